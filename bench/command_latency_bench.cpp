@@ -0,0 +1,115 @@
+// One-way control command latency: default blocking receive vs busy-poll mode.
+//
+// A sender thread emits encoded commands over loopback UDP at a fixed pace; the
+// receiver decodes each one and applies it to a DroneState, exactly like the
+// drone's update_position path. Each datagram carries its steady-clock send time
+// ahead of the command bytes, so latency is measured send -> applied.
+//
+// Build: g++ -std=c++17 -O2 -I.. command_latency_bench.cpp -o command_latency_bench -lpthread
+// Run:   ./command_latency_bench [samples] [interval_us] [receiver_core] [sender_core]
+
+#include <iostream>
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "cc_commands.hpp"
+#include "cc_lowlatency.hpp"
+
+using boost::asio::ip::udp;
+
+uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::vector<double> run_mode(bool busy_poll, size_t samples, int interval_us, int receiver_core, int sender_core)
+{
+    boost::asio::io_context io_context;
+    udp::socket receiver(io_context, udp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0));
+    udp::endpoint target = receiver.local_endpoint();
+    std::vector<double> latency_us;
+    latency_us.reserve(samples);
+    std::atomic<bool> ready(false);
+    std::atomic<size_t> received(0);
+
+    std::thread receiver_thread([&]()
+                                {
+                                    cc::ControlLatencyOptions options;
+                                    options.busy_poll = busy_poll;
+                                    options.core = receiver_core;
+                                    cc::configure_control_socket(receiver, options);
+                                    ready.store(true);
+
+                                    cc::DroneState state;
+                                    char data[64];
+                                    udp::endpoint sender;
+                                    while (latency_us.size() < samples)
+                                    {
+                                        boost::system::error_code error;
+                                        size_t length = cc::receive_control_datagram(receiver, boost::asio::buffer(data), sender, options, error);
+                                        if (error || length < sizeof(uint64_t))
+                                            continue;
+                                        uint64_t sent;
+                                        std::memcpy(&sent, data, sizeof(sent));
+                                        cc::Command command;
+                                        if (!cc::decode_command(data + sizeof(sent), length - sizeof(sent), command))
+                                            continue;
+                                        cc::apply_command(state, command);
+                                        latency_us.push_back((now_ns() - sent) / 1000.0);
+                                        received.store(latency_us.size(), std::memory_order_release);
+                                    } });
+
+    while (!ready.load())
+        std::this_thread::yield();
+
+    cc::pin_current_thread(sender_core, "sender");
+    udp::socket sender(io_context);
+    sender.open(udp::v4());
+    cc::Command command;
+    cc::parse_command("move front 1", command);
+    std::string wire = cc::encode_command(command);
+    std::vector<char> datagram(sizeof(uint64_t) + wire.size());
+    std::memcpy(datagram.data() + sizeof(uint64_t), wire.data(), wire.size());
+
+    // Send until the receiver has everything (a few datagrams may be lost on a busy host)
+    while (true)
+    {
+        uint64_t sent = now_ns();
+        std::memcpy(datagram.data(), &sent, sizeof(sent));
+        sender.send_to(boost::asio::buffer(datagram), target);
+        std::this_thread::sleep_for(std::chrono::microseconds(interval_us));
+        if (received.load(std::memory_order_acquire) >= samples)
+            break;
+    }
+    receiver_thread.join();
+    return latency_us;
+}
+
+void report(const std::string &mode, std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    auto at = [&samples](double p)
+    { return samples[static_cast<size_t>(p * (samples.size() - 1))]; };
+    std::cout << mode << ": n=" << samples.size() << " p50=" << at(0.50) << "us p90=" << at(0.90)
+              << "us p99=" << at(0.99) << "us p99.9=" << at(0.999) << "us max=" << samples.back() << "us" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t samples = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    int interval_us = argc > 2 ? std::atoi(argv[2]) : 200;
+    int receiver_core = argc > 3 ? std::atoi(argv[3]) : -1;
+    int sender_core = argc > 4 ? std::atoi(argv[4]) : -1;
+
+    if (std::thread::hardware_concurrency() < 2)
+        std::cout << "Warning: fewer than 2 cores; the busy-poll receiver competes with the sender and will look worse than it is." << std::endl;
+
+    report("default (blocking)", run_mode(false, samples, interval_us, receiver_core, sender_core));
+    report("busy-poll         ", run_mode(true, samples, interval_us, receiver_core, sender_core));
+    return 0;
+}
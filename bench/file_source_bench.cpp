@@ -0,0 +1,140 @@
+// File-transfer source throughput and page-cache footprint: the old ifstream loop
+// (1 KiB reads) against FileSource in mmap and double-buffered modes.
+//
+// Each run starts with the test file evicted from the page cache, streams it over
+// loopback TCP to a reader thread, and reports MB/s plus how much of the file is
+// still resident in the page cache afterwards (via mincore), which is what
+// drop-behind is meant to keep low. Loopback and a local disk are far faster than a
+// drone's flash, so absolute numbers overstate what a drone sees; the syscall count
+// and cache footprint differences carry over.
+//
+// Build: g++ -std=c++17 -O2 -I.. file_source_bench.cpp -o file_source_bench -lpthread
+// Run:   ./file_source_bench [file] [size_mb] [chunk_kb]
+
+#include <iostream>
+#include <boost/asio.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cc_filesource.hpp"
+
+using boost::asio::ip::tcp;
+
+void make_file(const std::string &path, size_t size)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    std::vector<char> block(1 << 20);
+    for (size_t i = 0; i < block.size(); ++i)
+        block[i] = static_cast<char>(i * 2654435761u >> 13);
+    for (size_t written = 0; written < size; written += block.size())
+        out.write(block.data(), static_cast<std::streamsize>(std::min(block.size(), size - written)));
+}
+
+void evict(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+
+// Fraction of the file's pages currently in the page cache
+double resident_fraction(const std::string &path, size_t size)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return -1.0;
+    long page = ::sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> pages((size + page - 1) / page);
+    ::mincore(mapping, size, pages.data());
+    ::munmap(mapping, size);
+    size_t resident = 0;
+    for (unsigned char p : pages)
+        resident += p & 1;
+    return static_cast<double>(resident) / pages.size();
+}
+
+// Streams the file over loopback TCP with send(socket) and returns MB/s
+template <typename Send>
+double over_loopback(size_t size, Send send)
+{
+    boost::asio::io_context io_context;
+    tcp::acceptor acceptor(io_context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    size_t received = 0;
+    std::thread reader([&]()
+                       {
+                           tcp::socket socket(io_context);
+                           acceptor.accept(socket);
+                           std::vector<char> buffer(256 * 1024);
+                           boost::system::error_code error;
+                           while (!error)
+                               received += socket.read_some(boost::asio::buffer(buffer), error); });
+
+    tcp::socket socket(io_context);
+    socket.connect(acceptor.local_endpoint());
+    auto start = std::chrono::steady_clock::now();
+    send(socket);
+    socket.shutdown(tcp::socket::shutdown_send);
+    reader.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (received != size)
+        std::cerr << "received " << received << " of " << size << " bytes" << std::endl;
+    return size / seconds / 1e6;
+}
+
+void report(const char *what, double mb_s, double resident)
+{
+    std::cout << std::left << std::setw(24) << what << mb_s << " MB/s, " << resident * 100.0 << "% of file left in page cache" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string path = argc > 1 ? argv[1] : "file_source_bench.bin";
+    size_t size = (argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256) << 20;
+    size_t chunk = (argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 64) << 10;
+    make_file(path, size);
+    std::cout << size / (1 << 20) << " MiB file, " << chunk / 1024 << " KiB sends" << std::endl;
+
+    evict(path);
+    double mb_s = over_loopback(size, [&](tcp::socket &socket)
+                                {
+                                    std::ifstream file(path, std::ios::binary);
+                                    char buffer[1024];
+                                    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+                                        boost::asio::write(socket, boost::asio::buffer(buffer, static_cast<size_t>(file.gcount()))); });
+    report("ifstream, 1 KiB:", mb_s, resident_fraction(path, size));
+
+    const cc::FileSourceMode modes[] = {cc::FileSourceMode::Mapped, cc::FileSourceMode::Buffered};
+    for (cc::FileSourceMode mode : modes)
+    {
+        for (bool drop_behind : {false, true})
+        {
+            evict(path);
+            cc::FileSourceOptions options;
+            options.mode = mode;
+            options.drop_behind = drop_behind;
+            mb_s = over_loopback(size, [&](tcp::socket &socket)
+                                 {
+                                     cc::FileSource source;
+                                     source.open(path, options);
+                                     const char *data;
+                                     size_t length;
+                                     while (source.next(data, length, chunk))
+                                         boost::asio::write(socket, boost::asio::buffer(data, length)); });
+            std::string label = std::string(mode == cc::FileSourceMode::Mapped ? "mmap" : "buffered") + (drop_behind ? " + drop-behind:" : ":");
+            report(label.c_str(), mb_s, resident_fraction(path, size));
+        }
+    }
+
+    ::unlink(path.c_str());
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Telemetry history: ingest cost, and query time per rollup level.
+//
+// Writes synthetic history (a random walk per drone, one sample per drone per
+// simulated second) into a fresh HistoryStore, then times:
+//   - a full-span track of one drone read from the raw samples and from the 1 s,
+//     1 min and 1 h rollups (the level track() picks for each step)
+//   - a fleet-wide "positions at time t" query, scanning drones on one thread and
+//     on every core
+//
+// Build: g++ -std=c++17 -O2 -I.. history_bench.cpp -o history_bench -lpthread
+// Run:   ./history_bench [dir] [drones] [hours]
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cc_history.hpp"
+
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    std::string dir = argc > 1 ? argv[1] : "history_bench.d";
+    int drones = argc > 2 ? std::atoi(argv[2]) : 50;
+    int hours = argc > 3 ? std::atoi(argv[3]) : 6;
+    std::system(("rm -rf '" + dir + "'").c_str());
+
+    const int64_t second = 1000000000ll;
+    const int64_t start = 1700000000ll * second;
+    const int64_t span = static_cast<int64_t>(hours) * 3600 * second;
+
+    // Simulated time runs far faster than real time; flush once per simulated minute
+    // rather than every simulated second so the run is not dominated by file opens
+    cc::HistoryOptions writing;
+    writing.flush_interval_ns = 60 * second;
+    cc::HistoryStore store;
+    store.open(dir, writing);
+    std::mt19937 rng(42);
+    std::normal_distribution<double> step(0.0, 5.0);
+    std::vector<double> x(drones, 0.0), y(drones, 0.0);
+    auto begin = std::chrono::steady_clock::now();
+    for (int64_t t = start; t < start + span; t += second)
+    {
+        for (int d = 0; d < drones; ++d)
+        {
+            x[d] += step(rng);
+            y[d] += step(rng);
+            store.record_wall(d + 1, t, x[d], y[d], 30.0);
+        }
+    }
+    store.close();
+    double elapsed = seconds_since(begin);
+    size_t samples = static_cast<size_t>(drones) * static_cast<size_t>(span / second);
+    std::cout << drones << " drones x " << hours << " h: " << samples << " samples written in " << elapsed << " s ("
+              << elapsed / samples * 1e9 << " ns per sample)" << std::endl;
+
+    cc::HistoryOptions serial;
+    serial.query_threads = 1;
+    cc::HistoryStore reader;
+    reader.open(dir, serial);
+    for (int64_t step_ns : {int64_t(0), second, 60 * second, 3600 * second})
+    {
+        int level;
+        begin = std::chrono::steady_clock::now();
+        std::vector<cc::HistoryRecord> track = reader.track(1, start, start + span, step_ns, level);
+        std::cout << "track, step " << step_ns / second << " s: " << track.size() << " points from the "
+                  << cc::history_level_names[level] << " level in " << seconds_since(begin) * 1e3 << " ms" << std::endl;
+    }
+
+    for (int64_t tolerance : {second, 3600 * second})
+    {
+        begin = std::chrono::steady_clock::now();
+        std::vector<cc::HistoryPosition> positions = reader.fleet_at(start + span / 2, tolerance);
+        std::cout << "fleet at t, tolerance " << tolerance / second << " s, 1 thread: " << positions.size() << " drones in "
+                  << seconds_since(begin) * 1e3 << " ms" << std::endl;
+    }
+    reader.close();
+
+    cc::HistoryStore parallel;
+    parallel.open(dir);
+    begin = std::chrono::steady_clock::now();
+    std::vector<cc::HistoryPosition> positions = parallel.fleet_at(start + span / 2, second);
+    std::cout << "fleet at t, tolerance 1 s, all " << std::max(1u, std::thread::hardware_concurrency()) << " core(s): " << positions.size()
+              << " drones in " << seconds_since(begin) * 1e3 << " ms" << std::endl;
+    parallel.close();
+
+    std::system(("rm -rf '" + dir + "'").c_str());
+    return 0;
+}
@@ -0,0 +1,1143 @@
+// End-to-end performance regression test: the multi-server under a simulated fleet,
+// over loopback, compared against a stored baseline.
+//
+// The tool starts the server binary in a scratch directory with its stdin and stdout
+// piped back here, registers N simulated drones with it, and runs scripted scenarios:
+//   steady    every drone sends telemetry at a fixed rate: lines delivered to the
+//             sink, server CPU per line
+//   flood     every drone sends telemetry as fast as the server reads it: lines/s
+//   commands  bursts of commands typed at the server prompt: prompt -> drone latency,
+//             commands/s, and the server's own command -> telemetry trace ("trace")
+//   uploads   several drones upload a large file at once through the upload
+//             scheduler: aggregate MB/s, per-upload time, files intact
+//   storm     every drone drops its telemetry connection and reconnects at once:
+//             time until the server has re-admitted the whole fleet
+// Each scenario also records the server's peak RSS. Together they cover the paths a
+// regression would show up in: handle_telemetry_data and the ingest pipeline,
+// send_commands and the drones' control receivers, and handle_file_transfer.
+//
+// Results print as "scenario.metric = value" lines, a config file (cc_config.hpp), so
+// --save writes a baseline and --baseline compares against one: a metric worse than
+// its baseline by more than its tolerance fails the run (exit status 3). Tolerances
+// are a fraction of the baseline, default by kind of metric (see add_metric) and can
+// be set per metric in the baseline file as "tolerance.<metric> = 0.3". The baseline
+// records the host it came from (CPU model and count). Throughput and CPU metrics
+// depend on that host, so against a baseline from another host they are printed but
+// only fail the run with --strict; delivery, latency and RSS are always checked.
+// --repeat N runs the scenarios N times and keeps each metric's median to steady
+// noisy machines.
+//
+// Build: g++ -std=c++17 -O2 -I.. perf_regression.cpp -o perf_regression -lpthread
+// Run:   ./perf_regression <server binary> [--drones N] [--scenarios steady,flood,commands,uploads,storm]
+//          [--seconds S] [--rate HZ] [--bursts N] [--burst N] [--uploads N] [--upload-mb N] [--repeat N]
+//          [--port N] [--baseline file] [--strict] [--save file] [--keep] [-- server args...]
+
+#include <iostream>
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <limits.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "cc_channel.hpp"
+#include "cc_commands.hpp"
+#include "cc_config.hpp"
+#include "cc_registration.hpp"
+#include "cc_trace.hpp"
+#include "cc_upload.hpp"
+
+using boost::asio::ip::tcp;
+using boost::asio::ip::udp;
+
+typedef cc::Channel<cc::UdpDatagram, cc::DatagramFraming, cc::NoCipher, cc::CommandCodec> CommandChannel;
+
+struct HarnessOptions
+{
+    std::string server_path;
+    std::vector<std::string> server_args;
+    std::vector<std::string> scenarios = {"steady", "flood", "commands", "uploads", "storm"};
+    size_t drones = 50;
+    double seconds = 5.0;   // Length of the steady and flood phases
+    double rate = 20.0;     // Telemetry lines per second per drone in the steady phase
+    size_t bursts = 20;     // Command bursts ...
+    size_t burst = 100;     // ... of this many commands, spread over the fleet
+    size_t uploads = 4;     // Concurrent uploads ...
+    size_t upload_mb = 64;  // ... of this many MiB each
+    int repeat = 1;
+    unsigned short port = 19001; // Telemetry port; files on port + 2, registration on port - 2
+    std::string baseline;
+    bool strict = false; // Check host-bound metrics against a baseline from another host
+    std::string save;
+    bool keep = false; // Keep the scratch directory
+};
+
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double percentile(std::vector<double> values, double fraction)
+{
+    if (values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(fraction * (values.size() - 1) + 0.5)];
+}
+
+// ---- The server under test
+
+class ServerProcess
+{
+public:
+    // Starts the server in dir with stdin and stdout piped; a reader thread follows its log
+    bool start(const std::string &path, const std::vector<std::string> &args, const std::string &dir)
+    {
+        int input[2], output[2];
+        if (pipe(input) != 0 || pipe(output) != 0)
+        {
+            std::perror("pipe");
+            return false;
+        }
+
+        pid_ = fork();
+        if (pid_ == 0)
+        {
+            dup2(input[0], STDIN_FILENO);
+            dup2(output[1], STDOUT_FILENO);
+            close(input[0]);
+            close(input[1]);
+            close(output[0]);
+            close(output[1]);
+            if (chdir(dir.c_str()) != 0)
+                _exit(127);
+            std::vector<char *> argv;
+            argv.push_back(const_cast<char *>(path.c_str()));
+            for (const auto &arg : args)
+                argv.push_back(const_cast<char *>(arg.c_str()));
+            argv.push_back(nullptr);
+            execv(path.c_str(), argv.data());
+            std::perror("execv");
+            _exit(127);
+        }
+
+        close(input[0]);
+        close(output[1]);
+        stdin_ = input[1];
+        reader_ = std::thread([this, fd = output[0]]()
+                              { follow(fd); });
+        return pid_ > 0;
+    }
+
+    void stop()
+    {
+        if (pid_ <= 0)
+            return;
+        kill(pid_, SIGKILL);
+        waitpid(pid_, nullptr, 0);
+        close(stdin_);
+        if (reader_.joinable())
+            reader_.join();
+        pid_ = -1;
+    }
+
+    // Types lines at the server's command prompt
+    void type(const std::string &lines)
+    {
+        size_t written = 0;
+        while (written < lines.size())
+        {
+            ssize_t length = ::write(stdin_, lines.data() + written, lines.size() - written);
+            if (length <= 0)
+                return;
+            written += static_cast<size_t>(length);
+        }
+    }
+
+    // Types a prompt command and returns the first count reply lines containing marker.
+    // Only ask while telemetry is quiet: the server's per-line log would interleave.
+    std::vector<std::string> query(const std::string &command, const char *marker, size_t count, int timeout_ms = 5000)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        replies_.clear();
+        lock.unlock();
+        type(command + "\n");
+        lock.lock();
+        std::vector<std::string> matches;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        replied_.wait_until(lock, deadline, [&]()
+                            {
+                                matches.clear();
+                                for (const auto &line : replies_)
+                                {
+                                    if (line.find(marker) != std::string::npos)
+                                        matches.push_back(line);
+                                }
+                                return matches.size() >= count; });
+        return matches;
+    }
+
+    // Items the sink stage has finished, from "stats" (0 if the server did not answer)
+    uint64_t sink_processed()
+    {
+        std::vector<std::string> lines = query("stats", "stage sink:", 1);
+        if (lines.empty())
+            return 0;
+        size_t out = lines[0].find(", out ");
+        return out == std::string::npos ? 0 : std::strtoull(lines[0].c_str() + out + 6, nullptr, 10);
+    }
+
+    size_t admitted() const { return admitted_.load(); }
+
+    // When the server logged the end of each drone's upload since the last call
+    std::map<int, uint64_t> take_completed_uploads()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<int, uint64_t> completed;
+        completed.swap(completed_uploads_);
+        return completed;
+    }
+
+    size_t completed_uploads()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return completed_uploads_.size();
+    }
+
+    // utime + stime from /proc/<pid>/stat, in seconds
+    double cpu_seconds() const
+    {
+        std::ifstream stat("/proc/" + std::to_string(pid_) + "/stat");
+        std::string text((std::istreambuf_iterator<char>(stat)), std::istreambuf_iterator<char>());
+        size_t paren = text.rfind(')');
+        if (paren == std::string::npos)
+            return 0.0;
+        std::istringstream fields(text.substr(paren + 2));
+        std::string skip;
+        for (int field = 3; field < 14; ++field) // state .. cmajflt
+            fields >> skip;
+        unsigned long long user = 0, system = 0;
+        fields >> user >> system;
+        return static_cast<double>(user + system) / static_cast<double>(sysconf(_SC_CLK_TCK));
+    }
+
+    // VmRSS from /proc/<pid>/status, in bytes
+    uint64_t rss_bytes() const
+    {
+        std::ifstream status("/proc/" + std::to_string(pid_) + "/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.compare(0, 6, "VmRSS:") == 0)
+                return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+        }
+        return 0;
+    }
+
+private:
+    void follow(int fd)
+    {
+        FILE *out = fdopen(fd, "r");
+        char buffer[8192];
+        while (std::fgets(buffer, sizeof(buffer), out))
+        {
+            // Per-line telemetry and command logs are the bulk of the output and never answers
+            if (std::strstr(buffer, "Received telemetry") || std::strstr(buffer, "Received datagram") || std::strstr(buffer, "Sent command:"))
+                continue;
+            if (std::strstr(buffer, "New telemetry client connected!"))
+            {
+                admitted_++;
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            const char *completed = std::strstr(buffer, "File transfer completed: drone");
+            if (completed)
+            {
+                completed_uploads_[std::atoi(completed + 30)] = cc::monotonic_ns();
+                continue;
+            }
+            if (replies_.size() < 1024)
+                replies_.push_back(buffer);
+            replied_.notify_all();
+        }
+        std::fclose(out);
+    }
+
+    pid_t pid_ = -1;
+    int stdin_ = -1;
+    std::thread reader_;
+    std::atomic<size_t> admitted_{0};
+    std::mutex mutex_;
+    std::condition_variable replied_;
+    std::vector<std::string> replies_;
+    std::map<int, uint64_t> completed_uploads_;
+};
+
+// Samples the server's RSS in the background and keeps the peak since the last reset
+class RssSampler
+{
+public:
+    explicit RssSampler(const ServerProcess &server) : server_(server), thread_([this]()
+                                                                               { run(); }) {}
+    ~RssSampler()
+    {
+        running_ = false;
+        thread_.join();
+    }
+
+    void reset() { peak_ = server_.rss_bytes(); }
+    double peak_mb() const { return peak_.load() / 1048576.0; }
+
+private:
+    void run()
+    {
+        while (running_)
+        {
+            uint64_t rss = server_.rss_bytes();
+            uint64_t peak = peak_.load();
+            while (rss > peak && !peak_.compare_exchange_weak(peak, rss))
+                ;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+
+    const ServerProcess &server_;
+    std::atomic<bool> running_{true};
+    std::atomic<uint64_t> peak_{0};
+    std::thread thread_;
+};
+
+// ---- The simulated fleet
+
+// One registered drone: a telemetry connection and a control receiver, each on its own thread
+struct SimDrone
+{
+    int id = 0;
+    unsigned short control_port = 0;
+    uint64_t seq = 0;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<cc::DroneHop> hops; // Commands applied since the last telemetry line
+    std::thread telemetry;
+    std::thread control;
+};
+
+struct Fleet
+{
+    unsigned short telemetry_port = 0;
+    unsigned short file_port = 0;
+    std::vector<std::unique_ptr<SimDrone>> drones;
+
+    std::atomic<bool> running{true};
+    std::atomic<double> rate{0.0};     // Telemetry lines per second per drone; < 0 floods
+    std::atomic<unsigned> epoch{0};    // Bumped to make every drone reconnect
+    std::atomic<uint64_t> lines_sent{0};
+    std::atomic<size_t> connected{0};
+
+    std::mutex mutex;
+    uint64_t storm_ns = 0;             // When the current reconnect storm began (0 = none)
+    std::vector<double> reconnect_ms;  // Per drone, storm start -> connected and first line sent
+
+    // Command k of the commands scenario is "goto k 0"; receipt time by k
+    std::unique_ptr<std::atomic<uint64_t>[]> command_rx;
+    size_t commands = 0;
+
+    void wake_all()
+    {
+        for (auto &drone : drones)
+        {
+            std::lock_guard<std::mutex> lock(drone->mutex);
+            drone->wake.notify_all();
+        }
+    }
+};
+
+void append_telemetry(SimDrone &drone, std::string &out, const std::vector<cc::DroneHop> &hops)
+{
+    char line[160];
+    uint64_t seq = ++drone.seq;
+    int length = std::snprintf(line, sizeof(line), "Telemetry data from Drone %d - Seq: %llu - Position: (%d.000000, %llu.000000) - Altitude: 30.000000",
+                               drone.id, static_cast<unsigned long long>(seq), drone.id * 100, static_cast<unsigned long long>(seq % 50));
+    out.append(line, static_cast<size_t>(length));
+    if (!hops.empty())
+        out += cc::format_trace_suffix(hops, cc::monotonic_ns()); // Echo command ids for the server's tracer
+    out += '\n';
+}
+
+// Holds the drone's telemetry connection, sending at the fleet's rate and right away
+// whenever a command needs echoing; reconnects when the epoch changes
+void telemetry_loop(Fleet &fleet, SimDrone &drone)
+{
+    const size_t flood_batch = 32;
+    boost::asio::io_context io_context;
+    tcp::endpoint server(boost::asio::ip::address_v4::loopback(), fleet.telemetry_port);
+    tcp::socket socket(io_context);
+    unsigned epoch = fleet.epoch.load();
+    auto next_due = std::chrono::steady_clock::now();
+    double paced_rate = 0.0;
+    std::string batch;
+    std::vector<cc::DroneHop> hops;
+
+    while (fleet.running)
+    {
+        boost::system::error_code error;
+        if (!socket.is_open())
+        {
+            socket.connect(server, error);
+            if (!error)
+            {
+                socket.set_option(tcp::no_delay(true), error);
+                batch.clear();
+                append_telemetry(drone, batch, hops);
+                boost::asio::write(socket, boost::asio::buffer(batch), error);
+            }
+            if (error)
+            {
+                socket.close(error);
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                continue;
+            }
+            fleet.lines_sent++;
+            fleet.connected++;
+            std::lock_guard<std::mutex> lock(fleet.mutex);
+            if (fleet.storm_ns != 0)
+                fleet.reconnect_ms.push_back((cc::monotonic_ns() - fleet.storm_ns) / 1e6);
+            continue;
+        }
+
+        double rate = fleet.rate.load();
+        if (rate > 0.0 && paced_rate <= 0.0)
+            next_due = std::chrono::steady_clock::now(); // A new phase starts now, not where the last one left off
+        paced_rate = rate;
+        {
+            std::unique_lock<std::mutex> lock(drone.mutex);
+            auto deadline = rate > 0.0 ? next_due : std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+            if (rate >= 0.0)
+                drone.wake.wait_until(lock, deadline, [&]()
+                                      { return !drone.hops.empty() || fleet.epoch.load() != epoch || !fleet.running; });
+            hops.swap(drone.hops);
+        }
+        if (fleet.epoch.load() != epoch)
+        {
+            epoch = fleet.epoch.load();
+            fleet.connected--;
+            socket.close(error);
+            hops.clear();
+            continue;
+        }
+
+        batch.clear();
+        size_t lines = 0;
+        if (!hops.empty())
+        {
+            append_telemetry(drone, batch, hops);
+            hops.clear();
+            ++lines;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (rate < 0.0)
+        {
+            for (size_t i = 0; i < flood_batch; ++i)
+                append_telemetry(drone, batch, hops);
+            lines += flood_batch;
+        }
+        else if (rate > 0.0 && now >= next_due)
+        {
+            append_telemetry(drone, batch, hops);
+            ++lines;
+            next_due += std::chrono::nanoseconds(static_cast<int64_t>(1e9 / rate));
+            if (now - next_due > std::chrono::seconds(1))
+                next_due = now; // Too far behind: start over rather than catch up
+        }
+        if (lines == 0)
+            continue;
+        boost::asio::write(socket, boost::asio::buffer(batch), error);
+        if (error)
+        {
+            fleet.connected--;
+            socket.close(error);
+            continue;
+        }
+        fleet.lines_sent += lines;
+    }
+}
+
+// Receives commands, stamps goto commands from the commands scenario, and queues every
+// command's trace hop for the next telemetry line
+void control_loop(Fleet &fleet, SimDrone &drone, udp::socket socket)
+{
+    CommandChannel control(cc::UdpDatagram(std::move(socket)));
+    while (fleet.running)
+    {
+        boost::system::error_code error;
+        cc::Frame frame;
+        if (!control.receive_frame(frame, error))
+            continue;
+        uint64_t received_ns = cc::monotonic_ns();
+        cc::Command command;
+        if (!CommandChannel::open(frame, command))
+            continue; // Includes the empty datagram that wakes us to exit
+
+        if (command.op == cc::Opcode::Goto && command.args[0] >= 0.0f && static_cast<size_t>(command.args[0]) < fleet.commands)
+            fleet.command_rx[static_cast<size_t>(command.args[0])] = received_ns;
+        std::lock_guard<std::mutex> lock(drone.mutex);
+        drone.hops.push_back(cc::DroneHop{command.id, received_ns, cc::monotonic_ns()});
+        drone.wake.notify_one();
+    }
+}
+
+// Registers n drones and starts their threads; returns false if the server never answered
+bool start_fleet(Fleet &fleet, size_t n, unsigned short registration_port)
+{
+    boost::asio::io_context io_context;
+    for (size_t i = 0; i < n; ++i)
+    {
+        cc::Registration registration;
+        std::string error;
+        bool registered = false;
+        for (int attempt = 0; attempt < 100 && !registered; ++attempt)
+        {
+            registered = cc::register_drone(io_context, "127.0.0.1", registration_port, 0, 0, registration, &error);
+            if (!registered)
+                std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Server still starting
+        }
+        if (!registered)
+        {
+            std::cerr << "Registration failed: " << error << std::endl;
+            return false;
+        }
+
+        std::unique_ptr<SimDrone> drone(new SimDrone());
+        drone->id = registration.drone_id;
+        drone->control_port = registration.control_port;
+        fleet.telemetry_port = registration.telemetry_port;
+        fleet.file_port = registration.file_port;
+        udp::socket control(io_context, udp::v4());
+        control.set_option(boost::asio::socket_base::reuse_address(true));
+        control.bind(udp::endpoint(udp::v4(), drone->control_port));
+        SimDrone &sim = *drone;
+        int fd = control.release();
+        sim.control = std::thread([&fleet, &sim, fd]()
+                                  {
+                                      boost::asio::io_context context;
+                                      control_loop(fleet, sim, udp::socket(context, udp::v4(), fd)); });
+        sim.telemetry = std::thread([&fleet, &sim]()
+                                    { telemetry_loop(fleet, sim); });
+        fleet.drones.push_back(std::move(drone));
+    }
+    return true;
+}
+
+void stop_fleet(Fleet &fleet)
+{
+    fleet.running = false;
+    fleet.wake_all();
+    boost::asio::io_context io_context;
+    udp::socket waker(io_context, udp::v4());
+    for (auto &drone : fleet.drones)
+    {
+        boost::system::error_code ignored;
+        waker.send_to(boost::asio::buffer("", 0), udp::endpoint(boost::asio::ip::address_v4::loopback(), drone->control_port), 0, ignored);
+        drone->control.join();
+        drone->telemetry.join();
+    }
+}
+
+// ---- Metrics and baselines
+
+enum class Better
+{
+    Higher,
+    Lower
+};
+
+struct Metric
+{
+    std::string name;
+    double value;
+    Better better;
+    double tolerance; // Default allowed change, as a fraction of the baseline
+    bool host_bound;  // Throughput or CPU: only comparable on the host the baseline came from
+};
+
+// Default tolerances: tail latencies on a shared box move a lot, throughput and CPU
+// with the load from other processes; delivery must not drop at all. Idle CPU (cores
+// in use at a steady rate) is a few percent of a core and swings several-fold between
+// runs, so it only fails at three times the baseline, which still catches a spinning stage.
+void add_metric(std::vector<Metric> &metrics, const std::string &name, double value, Better better)
+{
+    bool host_bound = name.find("per_s") != std::string::npos || name.find("cpu") != std::string::npos;
+    double tolerance = 0.25;
+    if (name.find("delivered") != std::string::npos)
+        tolerance = 0.0;
+    else if (name.find("cores") != std::string::npos)
+        tolerance = 2.0;
+    else if (name.find("p99") != std::string::npos || name.find("max") != std::string::npos)
+        tolerance = 1.0;
+    else if (host_bound || name.find("p50") != std::string::npos || name.find("_ms") != std::string::npos)
+        tolerance = 0.5;
+    metrics.push_back(Metric{name, value, better, tolerance, host_bound});
+}
+
+// CPU model and count, as recorded in a baseline
+std::string host_description()
+{
+    std::string model = "unknown CPU";
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line))
+    {
+        size_t colon = line.find(':');
+        if (line.compare(0, 10, "model name") == 0 && colon != std::string::npos)
+        {
+            model = line.substr(line.find_first_not_of(" \t", colon + 1));
+            break;
+        }
+    }
+    std::replace(model.begin(), model.end(), '#', ' '); // Would start a comment in the baseline file
+    return model + ", " + std::to_string(std::thread::hardware_concurrency()) + " CPUs";
+}
+
+// ---- Scenarios
+
+struct Harness
+{
+    const HarnessOptions &options;
+    ServerProcess &server;
+    RssSampler &rss;
+    Fleet &fleet;
+    std::string dir;
+    std::vector<Metric> metrics;
+
+    // Waits until the sink has processed everything the fleet sent since before (lines
+    // still being written when a phase ends count too), or stops moving. Returns the
+    // number processed since before.
+    uint64_t drain(uint64_t before)
+    {
+        uint64_t processed = server.sink_processed();
+        auto last_change = std::chrono::steady_clock::now();
+        while (processed < before + fleet.lines_sent.load() && seconds_since(last_change) < 2.0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            uint64_t now = server.sink_processed();
+            if (now != processed)
+                last_change = std::chrono::steady_clock::now();
+            processed = now;
+        }
+        return processed - std::min(processed, before);
+    }
+
+    // Waits for the sink to stop moving (lines from an earlier phase still in the
+    // pipeline) and returns its count
+    uint64_t settle()
+    {
+        uint64_t processed = server.sink_processed();
+        for (int i = 0; i < 50; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            uint64_t now = server.sink_processed();
+            if (now == processed)
+                break;
+            processed = now;
+        }
+        return processed;
+    }
+
+    // An unmeasured flood first, so every run starts with the server's buffer pools,
+    // slabs and heap as warm as they are after a busy spell
+    void warm_up()
+    {
+        uint64_t before = settle();
+        fleet.lines_sent = 0;
+        fleet.rate = -1.0;
+        fleet.wake_all();
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        fleet.rate = 0.0;
+        drain(before);
+    }
+
+    // CPU is taken over the sending window only; the drain's "stats" polling is not load
+    void steady()
+    {
+        uint64_t before = settle();
+        fleet.lines_sent = 0;
+        rss.reset();
+        double cpu = server.cpu_seconds();
+        auto start = std::chrono::steady_clock::now();
+        fleet.rate = options.rate;
+        fleet.wake_all();
+        std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+        fleet.rate = 0.0;
+        double cores = (server.cpu_seconds() - cpu) / seconds_since(start);
+        uint64_t processed = drain(before);
+        uint64_t sent = fleet.lines_sent.load();
+
+        std::cout << "steady: " << sent << " lines sent at " << options.rate << " Hz per drone, " << processed << " processed, server at " << cores << " core(s)" << std::endl;
+        add_metric(metrics, "steady.delivered", sent ? static_cast<double>(processed) / sent : 0.0, Better::Higher);
+        add_metric(metrics, "steady.cpu_cores", cores, Better::Lower);
+        add_metric(metrics, "steady.rss_mb", rss.peak_mb(), Better::Lower);
+    }
+
+    // Throughput counts the time the server takes to work off its backlog after the phase
+    void flood()
+    {
+        uint64_t before = settle();
+        fleet.lines_sent = 0;
+        rss.reset();
+        double cpu = server.cpu_seconds();
+        auto start = std::chrono::steady_clock::now();
+        fleet.rate = -1.0;
+        fleet.wake_all();
+        std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+        fleet.rate = 0.0;
+        uint64_t processed = drain(before);
+        uint64_t sent = fleet.lines_sent.load();
+        double elapsed = seconds_since(start);
+        cpu = server.cpu_seconds() - cpu;
+
+        std::cout << "flood: " << sent << " lines sent, " << processed << " processed in " << elapsed << " s" << std::endl;
+        add_metric(metrics, "flood.lines_per_s", processed / elapsed, Better::Higher);
+        add_metric(metrics, "flood.cpu_us_per_line", processed ? cpu * 1e6 / processed : 0.0, Better::Lower);
+        add_metric(metrics, "flood.rss_mb", rss.peak_mb(), Better::Lower);
+    }
+
+    void commands()
+    {
+        rss.reset();
+        fleet.commands = options.bursts * options.burst;
+        fleet.command_rx.reset(new std::atomic<uint64_t>[fleet.commands]());
+        std::vector<double> latencies_us, rates;
+        size_t received = 0;
+        for (size_t b = 0; b < options.bursts; ++b)
+        {
+            std::string burst;
+            for (size_t j = 0; j < options.burst; ++j)
+            {
+                size_t k = b * options.burst + j;
+                burst += std::to_string(fleet.drones[k % fleet.drones.size()]->id) + " goto " + std::to_string(k) + " 0\n";
+            }
+            uint64_t typed_ns = cc::monotonic_ns();
+            server.type(burst);
+
+            // Wait for the burst to land (or give up on what was lost)
+            auto start = std::chrono::steady_clock::now();
+            uint64_t last_ns = 0;
+            size_t landed = 0;
+            while (seconds_since(start) < 2.0)
+            {
+                landed = 0;
+                for (size_t k = b * options.burst; k < (b + 1) * options.burst; ++k)
+                {
+                    uint64_t rx = fleet.command_rx[k].load();
+                    landed += rx != 0;
+                    last_ns = std::max(last_ns, rx);
+                }
+                if (landed == options.burst)
+                    break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            for (size_t k = b * options.burst; k < (b + 1) * options.burst; ++k)
+            {
+                uint64_t rx = fleet.command_rx[k].load();
+                if (rx > typed_ns)
+                    latencies_us.push_back((rx - typed_ns) / 1e3);
+            }
+            received += landed;
+            if (landed > 0 && last_ns > typed_ns)
+                rates.push_back(landed / ((last_ns - typed_ns) / 1e9));
+            std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Let the echoing telemetry settle
+        }
+
+        // The server's own trace: sent -> drone_rx -> applied -> telemetry back at the server
+        double loop_p50 = 0.0, loop_p99 = 0.0;
+        std::vector<std::string> trace = server.query("trace", "total:", 1);
+        if (!trace.empty())
+        {
+            size_t p50 = trace[0].find("p50="), p99 = trace[0].find("p99=");
+            if (p50 != std::string::npos && p99 != std::string::npos)
+            {
+                loop_p50 = std::strtod(trace[0].c_str() + p50 + 4, nullptr);
+                loop_p99 = std::strtod(trace[0].c_str() + p99 + 4, nullptr);
+            }
+        }
+
+        size_t total = options.bursts * options.burst;
+        std::cout << "commands: " << received << " of " << total << " delivered in " << options.bursts << " burst(s) of " << options.burst << std::endl;
+        add_metric(metrics, "commands.delivered", static_cast<double>(received) / total, Better::Higher);
+        add_metric(metrics, "commands.per_s", percentile(rates, 0.5), Better::Higher);
+        add_metric(metrics, "commands.p50_us", percentile(latencies_us, 0.50), Better::Lower);
+        add_metric(metrics, "commands.p99_us", percentile(latencies_us, 0.99), Better::Lower);
+        add_metric(metrics, "commands.loop_p50_us", loop_p50, Better::Lower);
+        add_metric(metrics, "commands.loop_p99_us", loop_p99, Better::Lower);
+        add_metric(metrics, "commands.rss_mb", rss.peak_mb(), Better::Lower);
+    }
+
+    void uploads()
+    {
+        size_t count = std::min(options.uploads, fleet.drones.size());
+        uint64_t bytes = static_cast<uint64_t>(options.upload_mb) << 20;
+        std::vector<char> block(1 << 18);
+        for (size_t i = 0; i < block.size(); ++i)
+            block[i] = static_cast<char>(i * 2654435761u >> 13);
+
+        rss.reset();
+        server.take_completed_uploads();
+        double cpu = server.cpu_seconds();
+        uint64_t start_ns = cc::monotonic_ns();
+        std::vector<std::thread> senders;
+        for (size_t i = 0; i < count; ++i)
+        {
+            int drone_id = fleet.drones[i]->id;
+            senders.emplace_back([this, drone_id, bytes, &block]()
+                                 {
+                                     try
+                                     {
+                                         boost::asio::io_context io_context;
+                                         tcp::endpoint server_endpoint(boost::asio::ip::address_v4::loopback(), fleet.file_port);
+                                         while (true)
+                                         {
+                                             tcp::socket socket(io_context);
+                                             socket.connect(server_endpoint);
+                                             boost::asio::write(socket, boost::asio::buffer(cc::format_upload_request(drone_id, bytes, cc::UploadPriority::Normal)));
+                                             std::string reply, rest;
+                                             bool go = false;
+                                             uint64_t wait_ms = 0;
+                                             if (!cc::read_line(socket, reply, rest, 30000) || !cc::parse_upload_reply(reply, go, wait_ms))
+                                                 throw std::runtime_error("no answer to upload request");
+                                             if (!go)
+                                             {
+                                                 socket.close();
+                                                 std::this_thread::sleep_for(std::chrono::milliseconds(wait_ms));
+                                                 continue;
+                                             }
+                                             for (uint64_t sent = 0; sent < bytes; sent += block.size())
+                                                 boost::asio::write(socket, boost::asio::buffer(block.data(), static_cast<size_t>(std::min<uint64_t>(block.size(), bytes - sent))));
+                                             socket.shutdown(tcp::socket::shutdown_send);
+                                             return;
+                                         }
+                                     }
+                                     catch (std::exception &e)
+                                     {
+                                         std::cerr << "Drone " << drone_id << " upload failed: " << e.what() << std::endl;
+                                     } });
+        }
+        for (auto &sender : senders)
+            sender.join();
+        auto waiting = std::chrono::steady_clock::now();
+        while (server.completed_uploads() < count && seconds_since(waiting) < 30.0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        cpu = server.cpu_seconds() - cpu;
+
+        std::map<int, uint64_t> completed = server.take_completed_uploads();
+        std::vector<double> times_ms;
+        uint64_t last_ns = start_ns;
+        size_t intact = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            int drone_id = fleet.drones[i]->id;
+            std::string path = dir + "/drone" + std::to_string(drone_id) + "_file.txt";
+            struct stat info;
+            if (::stat(path.c_str(), &info) == 0 && static_cast<uint64_t>(info.st_size) == bytes)
+                ++intact;
+            ::unlink(path.c_str());
+            auto it = completed.find(drone_id);
+            if (it == completed.end())
+                continue;
+            times_ms.push_back((it->second - start_ns) / 1e6);
+            last_ns = std::max(last_ns, it->second);
+        }
+        double seconds = (last_ns - start_ns) / 1e9;
+        double megabytes = static_cast<double>(bytes) * times_ms.size() / 1e6;
+
+        std::cout << "uploads: " << times_ms.size() << " of " << count << " x " << options.upload_mb << " MiB completed, " << intact << " intact" << std::endl;
+        add_metric(metrics, "uploads.delivered", static_cast<double>(intact) / count, Better::Higher);
+        add_metric(metrics, "uploads.mb_per_s", seconds > 0.0 ? megabytes / seconds : 0.0, Better::Higher);
+        add_metric(metrics, "uploads.p50_ms", percentile(times_ms, 0.5), Better::Lower);
+        add_metric(metrics, "uploads.max_ms", percentile(times_ms, 1.0), Better::Lower);
+        add_metric(metrics, "uploads.cpu_ms_per_mb", megabytes > 0.0 ? cpu * 1e3 / megabytes : 0.0, Better::Lower);
+        add_metric(metrics, "uploads.rss_mb", rss.peak_mb(), Better::Lower);
+    }
+
+    void storm()
+    {
+        size_t drones = fleet.drones.size();
+        rss.reset();
+        size_t admitted = server.admitted();
+        {
+            std::lock_guard<std::mutex> lock(fleet.mutex);
+            fleet.reconnect_ms.clear();
+            fleet.storm_ns = cc::monotonic_ns();
+        }
+        auto start = std::chrono::steady_clock::now();
+        fleet.epoch++;
+        fleet.wake_all();
+
+        double recovery_ms = -1.0;
+        while (seconds_since(start) < 60.0)
+        {
+            bool reconnected;
+            {
+                std::lock_guard<std::mutex> lock(fleet.mutex);
+                reconnected = fleet.reconnect_ms.size() >= drones;
+            }
+            if (reconnected && server.admitted() - admitted >= drones)
+            {
+                recovery_ms = seconds_since(start) * 1e3;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::vector<double> reconnect_ms;
+        {
+            std::lock_guard<std::mutex> lock(fleet.mutex);
+            fleet.storm_ns = 0;
+            reconnect_ms = fleet.reconnect_ms;
+        }
+
+        if (recovery_ms < 0)
+            std::cout << "storm: NOT recovered within 60 s (" << server.admitted() - admitted << "/" << drones << " admitted)" << std::endl;
+        else
+            std::cout << "storm: " << drones << " drones reconnected and re-admitted in " << recovery_ms << " ms" << std::endl;
+        add_metric(metrics, "storm.recovery_ms", recovery_ms < 0 ? 60000.0 : recovery_ms, Better::Lower);
+        add_metric(metrics, "storm.connect_p99_ms", percentile(reconnect_ms, 0.99), Better::Lower);
+        add_metric(metrics, "storm.rss_mb", rss.peak_mb(), Better::Lower);
+    }
+};
+
+// Per metric, the median over the runs
+std::vector<Metric> median_of(const std::vector<std::vector<Metric>> &runs)
+{
+    std::vector<Metric> merged = runs.front();
+    for (auto &metric : merged)
+    {
+        std::vector<double> values;
+        for (const auto &run : runs)
+        {
+            for (const auto &other : run)
+            {
+                if (other.name == metric.name)
+                    values.push_back(other.value);
+            }
+        }
+        metric.value = percentile(values, 0.5);
+    }
+    return merged;
+}
+
+bool save_baseline(const std::string &path, const std::vector<Metric> &metrics, const HarnessOptions &options)
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out)
+        return false;
+    out << "# perf_regression baseline: " << options.drones << " drones, " << options.seconds << " s phases, "
+        << options.rate << " Hz steady, " << options.bursts << "x" << options.burst << " commands, "
+        << options.uploads << "x" << options.upload_mb << " MiB uploads\n";
+    out << "# Throughput and CPU metrics are only checked on this host (or with --strict).\n";
+    out << "host = " << host_description() << "\n";
+    for (const auto &metric : metrics)
+        out << metric.name << " = " << metric.value << "\n";
+    out << "\n# Allowed change as a fraction of the baseline value\n";
+    for (const auto &metric : metrics)
+        out << "tolerance." << metric.name << " = " << metric.tolerance << "\n";
+    return true;
+}
+
+// Prints each metric against the baseline; returns the number of regressions
+size_t compare(const std::vector<Metric> &metrics, const cc::Config &baseline, bool strict)
+{
+    std::string host = host_description();
+    bool same_host = baseline.get("host") == host;
+    if (!same_host)
+        std::cout << "Baseline host: " << baseline.get("host", "not recorded") << std::endl
+                  << "This host:     " << host << std::endl
+                  << (strict ? "Checking throughput and CPU anyway (--strict)" : "Throughput and CPU metrics are for information only (--strict to check them)") << std::endl;
+
+    size_t regressions = 0;
+    for (const auto &metric : metrics)
+    {
+        if (!baseline.has(metric.name))
+        {
+            std::cout << "  new   " << std::left << std::setw(28) << metric.name << metric.value << " (no baseline)" << std::endl;
+            continue;
+        }
+        double base = baseline.get_double(metric.name, 0.0);
+        double tolerance = baseline.get_double("tolerance." + metric.name, metric.tolerance);
+        double change = base != 0.0 ? (metric.value - base) / base : 0.0;
+        bool worse = metric.better == Better::Higher ? metric.value < base * (1.0 - tolerance) : metric.value > base * (1.0 + tolerance);
+        bool checked = same_host || strict || !metric.host_bound;
+        regressions += worse && checked;
+        std::cout << (!checked ? "  info  " : worse ? "  FAIL  " : "  ok    ") << std::left << std::setw(28) << metric.name << metric.value
+                  << " (baseline " << base << ", " << std::showpos << std::fixed << std::setprecision(1) << change * 100.0 << std::noshowpos
+                  << "%, tolerance " << tolerance * 100.0 << "%)" << std::defaultfloat << std::setprecision(6) << std::endl;
+    }
+    return regressions;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argv[1][0] == '-')
+    {
+        std::cout << "Usage: " << argv[0] << " <server binary> [--drones N] [--scenarios steady,flood,commands,uploads,storm] [--seconds S] [--rate HZ]"
+                  << " [--bursts N] [--burst N] [--uploads N] [--upload-mb N] [--repeat N] [--port N] [--baseline file] [--strict] [--save file] [--keep] [-- server args...]" << std::endl;
+        return 1;
+    }
+
+    // Harness settings before "--", server arguments after it
+    int split = 2;
+    while (split < argc && std::strcmp(argv[split], "--") != 0)
+        ++split;
+    std::vector<char *> harness_argv(argv, argv + split);
+    cc::Config config;
+    config.load(static_cast<int>(harness_argv.size()), harness_argv.data());
+
+    HarnessOptions options;
+    char resolved[PATH_MAX];
+    options.server_path = realpath(argv[1], resolved) ? resolved : argv[1];
+    options.drones = static_cast<size_t>(std::max(1L, config.get_int("drones", static_cast<long>(options.drones))));
+    options.seconds = std::max(0.5, config.get_double("seconds", options.seconds));
+    options.rate = std::max(0.1, config.get_double("rate", options.rate));
+    options.bursts = static_cast<size_t>(std::max(1L, config.get_int("bursts", static_cast<long>(options.bursts))));
+    options.burst = static_cast<size_t>(std::max(1L, config.get_int("burst", static_cast<long>(options.burst))));
+    options.uploads = static_cast<size_t>(std::max(1L, config.get_int("uploads", static_cast<long>(options.uploads))));
+    options.upload_mb = static_cast<size_t>(std::max(1L, config.get_int("upload_mb", static_cast<long>(options.upload_mb))));
+    options.repeat = static_cast<int>(std::max(1L, config.get_int("repeat", options.repeat)));
+    options.port = static_cast<unsigned short>(config.get_int("port", options.port));
+    options.baseline = config.get("baseline");
+    options.strict = config.get_bool("strict", false);
+    options.save = config.get("save");
+    options.keep = config.get_bool("keep", false);
+    if (config.has("scenarios"))
+    {
+        options.scenarios.clear();
+        std::istringstream names(config.get("scenarios"));
+        std::string name;
+        while (std::getline(names, name, ','))
+            options.scenarios.push_back(name);
+    }
+
+    // Fixed ports away from a real deployment's; anything after "--" can override them
+    unsigned short registration_port = static_cast<unsigned short>(options.port - 2);
+    options.server_args = {"--telemetry_port", std::to_string(options.port), "--file_port", std::to_string(options.port + 2),
+                           "--registration_port", std::to_string(registration_port), "--control_port_base", std::to_string(options.port + 1000)};
+    for (int i = split + 1; i < argc; ++i)
+        options.server_args.push_back(argv[i]);
+
+    cc::Config baseline;
+    std::string baseline_error;
+    if (!options.baseline.empty() && !baseline.load_file(options.baseline, &baseline_error))
+    {
+        std::cerr << baseline_error << std::endl;
+        return 1;
+    }
+
+    // Each simulated drone needs descriptors here and in the server
+    rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    signal(SIGPIPE, SIG_IGN);
+
+    char scratch[] = "/tmp/cc_perf.XXXXXX";
+    if (!mkdtemp(scratch))
+    {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    std::string dir = scratch;
+
+    ServerProcess server;
+    if (!server.start(options.server_path, options.server_args, dir))
+        return 1;
+    Fleet fleet;
+    if (!start_fleet(fleet, options.drones, registration_port))
+    {
+        server.stop();
+        return 1;
+    }
+
+    // Wait for the fleet's telemetry sessions to be admitted
+    auto start = std::chrono::steady_clock::now();
+    while ((fleet.connected.load() < options.drones || server.admitted() < options.drones) && seconds_since(start) < 30.0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    std::cout << options.drones << " drones registered and connected in " << seconds_since(start) << " s; scratch directory " << dir << std::endl;
+
+    RssSampler rss(server);
+    std::vector<std::vector<Metric>> runs;
+    for (int run = 0; run < options.repeat; ++run)
+    {
+        if (options.repeat > 1)
+            std::cout << "Run " << run + 1 << " of " << options.repeat << ":" << std::endl;
+        Harness harness{options, server, rss, fleet, dir, {}};
+        if (run == 0)
+            harness.warm_up();
+        for (const auto &scenario : options.scenarios)
+        {
+            if (scenario == "steady")
+                harness.steady();
+            else if (scenario == "flood")
+                harness.flood();
+            else if (scenario == "commands")
+                harness.commands();
+            else if (scenario == "uploads")
+                harness.uploads();
+            else if (scenario == "storm")
+                harness.storm();
+            else
+                std::cerr << "Unknown scenario: " << scenario << std::endl;
+        }
+        runs.push_back(std::move(harness.metrics));
+    }
+
+    server.stop();
+    stop_fleet(fleet);
+    if (!options.keep)
+        std::system(("rm -rf '" + dir + "'").c_str());
+    if (runs.front().empty())
+        return 1;
+
+    std::vector<Metric> metrics = median_of(runs);
+    std::cout << std::endl;
+    for (const auto &metric : metrics)
+        std::cout << metric.name << " = " << metric.value << std::endl;
+
+    if (!options.save.empty())
+    {
+        if (!save_baseline(options.save, metrics, options))
+        {
+            std::cerr << "Cannot write " << options.save << std::endl;
+            return 1;
+        }
+        std::cout << "Baseline written to " << options.save << std::endl;
+    }
+
+    if (options.baseline.empty())
+        return 0;
+    std::cout << std::endl
+              << "Against " << options.baseline << ":" << std::endl;
+    size_t regressions = compare(metrics, baseline, options.strict);
+    if (regressions > 0)
+    {
+        std::cout << regressions << " metric(s) regressed" << std::endl;
+        return 3;
+    }
+    std::cout << "No regressions" << std::endl;
+    return 0;
+}
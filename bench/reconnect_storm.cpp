@@ -0,0 +1,277 @@
+// Reconnect-storm test: restart the server under a large simulated fleet and
+// measure time to full recovery.
+//
+// The tool launches the server, connects N simulated drones (each sends one
+// telemetry line and then holds its connection), kills the server once the whole
+// fleet is admitted, restarts it, and reports how long the fleet takes to be fully
+// re-admitted. Admission is counted from the server's own "New telemetry client
+// connected!" log lines, so sessions parked in the kernel backlog do not count.
+//
+// Build: g++ -std=c++17 -O2 -I.. reconnect_storm.cpp -o reconnect_storm -lpthread
+// Run:   ./reconnect_storm <server binary> [drones] [--down-ms N] [--base-ms N] [--cap-ms N] [--fixed-ms N] [-- server args...]
+//        --fixed-ms reproduces the old fixed-delay retry loop for comparison.
+
+#include <iostream>
+#include <boost/asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "cc_backoff.hpp"
+
+using boost::asio::ip::tcp;
+
+struct StormOptions
+{
+    std::string server_path;
+    std::vector<std::string> server_args;
+    size_t drones = 10000;
+    int down_ms = 1000;
+    int base_ms = 500;
+    int cap_ms = 30000;
+    int fixed_ms = 0; // > 0: fixed retry delay instead of jittered backoff
+    unsigned short port = 9001;
+};
+
+std::atomic<size_t> connected_drones(0);
+std::atomic<size_t> admitted_sessions(0);
+
+// One simulated drone: connect, send a telemetry line, hold the connection, and
+// reconnect with backoff when the server goes away
+struct SimDrone : std::enable_shared_from_this<SimDrone>
+{
+    SimDrone(boost::asio::io_context &io_context, int id, const StormOptions &options)
+        : id(id), options(options), socket(io_context), timer(io_context),
+          backoff(std::chrono::milliseconds(options.base_ms), std::chrono::milliseconds(options.cap_ms), static_cast<unsigned>(id) * 2654435761u) {}
+
+    void connect()
+    {
+        auto self = shared_from_this();
+        socket = tcp::socket(timer.get_executor());
+        tcp::endpoint server(boost::asio::ip::make_address("127.0.0.1"), options.port);
+        socket.async_connect(server, [self](const boost::system::error_code &error)
+                             {
+                                 if (error)
+                                 {
+                                     self->retry();
+                                     return;
+                                 }
+                                 self->line = "Telemetry data from Drone " + std::to_string(self->id) + " - Position: (" + std::to_string(self->id % 1000 * 100) + ", " + std::to_string(self->id / 1000 * 100) + ")\n";
+                                 boost::asio::async_write(self->socket, boost::asio::buffer(self->line), [self](const boost::system::error_code &error, size_t)
+                                                          {
+                                                              if (error)
+                                                              {
+                                                                  self->retry();
+                                                                  return;
+                                                              }
+                                                              self->connected = true;
+                                                              self->backoff.reset();
+                                                              connected_drones++;
+                                                              self->watch();
+                                                          }); });
+    }
+
+    // The server never writes, so a completed read means the connection died
+    void watch()
+    {
+        auto self = shared_from_this();
+        socket.async_read_some(boost::asio::buffer(scratch), [self](const boost::system::error_code &, size_t)
+                               {
+                                   if (self->connected)
+                                   {
+                                       self->connected = false;
+                                       connected_drones--;
+                                   }
+                                   self->retry(); });
+    }
+
+    void retry()
+    {
+        boost::system::error_code ignored;
+        socket.close(ignored);
+        auto delay = options.fixed_ms > 0 ? std::chrono::milliseconds(options.fixed_ms) : backoff.next();
+        timer.expires_after(delay);
+        auto self = shared_from_this();
+        timer.async_wait([self](const boost::system::error_code &error)
+                         {
+                             if (!error)
+                                 self->connect(); });
+    }
+
+    int id;
+    const StormOptions &options;
+    tcp::socket socket;
+    boost::asio::steady_timer timer;
+    cc::DecorrelatedJitter backoff;
+    bool connected = false;
+    std::string line;
+    char scratch[64];
+};
+
+// Starts the server with stdout piped back to us; a reader thread counts admitted sessions
+pid_t launch_server(const StormOptions &options, std::thread &reader)
+{
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0)
+    {
+        std::perror("pipe");
+        std::exit(1);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        dup2(pipe_fds[1], STDOUT_FILENO);
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        std::vector<char *> argv;
+        argv.push_back(const_cast<char *>(options.server_path.c_str()));
+        for (const auto &arg : options.server_args)
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        argv.push_back(nullptr);
+        execv(options.server_path.c_str(), argv.data());
+        std::perror("execv");
+        _exit(127);
+    }
+
+    close(pipe_fds[1]);
+    reader = std::thread([fd = pipe_fds[0]]()
+                         {
+                             FILE *out = fdopen(fd, "r");
+                             char buffer[4096];
+                             while (std::fgets(buffer, sizeof(buffer), out))
+                             {
+                                 if (std::strstr(buffer, "New telemetry client connected!"))
+                                     admitted_sessions++;
+                             }
+                             std::fclose(out); });
+    return pid;
+}
+
+void stop_server(pid_t pid, std::thread &reader)
+{
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    if (reader.joinable())
+        reader.join();
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Waits until the fleet is fully connected and admitted; prints milestones. Returns seconds or -1 on timeout.
+double wait_for_fleet(size_t drones, std::chrono::steady_clock::time_point start, double timeout_s)
+{
+    double milestones[] = {0.5, 0.9, 0.99};
+    size_t next_milestone = 0;
+    while (seconds_since(start) < timeout_s)
+    {
+        size_t admitted = admitted_sessions.load();
+        while (next_milestone < 3 && admitted >= static_cast<size_t>(milestones[next_milestone] * drones))
+        {
+            std::cout << "  " << static_cast<int>(milestones[next_milestone] * 100) << "% admitted after " << seconds_since(start) << " s" << std::endl;
+            ++next_milestone;
+        }
+        if (admitted >= drones && connected_drones.load() >= drones)
+            return seconds_since(start);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return -1.0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " <server binary> [drones] [--down-ms N] [--base-ms N] [--cap-ms N] [--fixed-ms N] [-- server args...]" << std::endl;
+        return 1;
+    }
+
+    StormOptions options;
+    options.server_path = argv[1];
+    int i = 2;
+    if (i < argc && argv[i][0] != '-')
+        options.drones = std::strtoul(argv[i++], nullptr, 10);
+    for (; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--")
+        {
+            for (++i; i < argc; ++i)
+                options.server_args.push_back(argv[i]);
+            break;
+        }
+        if (i + 1 >= argc)
+            break;
+        if (arg == "--down-ms")
+            options.down_ms = std::atoi(argv[++i]);
+        else if (arg == "--base-ms")
+            options.base_ms = std::atoi(argv[++i]);
+        else if (arg == "--cap-ms")
+            options.cap_ms = std::atoi(argv[++i]);
+        else if (arg == "--fixed-ms")
+            options.fixed_ms = std::atoi(argv[++i]);
+    }
+
+    // Each simulated drone needs a descriptor here and one in the server
+    rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    if (limit.rlim_cur < options.drones + 64)
+        std::cout << "Warning: descriptor limit " << limit.rlim_cur << " is too low for " << options.drones << " drones" << std::endl;
+
+    std::cout << "Reconnect storm: " << options.drones << " drones, server down for " << options.down_ms << " ms, "
+              << (options.fixed_ms > 0 ? "fixed " + std::to_string(options.fixed_ms) + " ms retry" : "jittered backoff " + std::to_string(options.base_ms) + "-" + std::to_string(options.cap_ms) + " ms") << std::endl;
+
+    std::thread reader;
+    pid_t server = launch_server(options, reader);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    boost::asio::io_context io_context;
+    auto guard = boost::asio::make_work_guard(io_context);
+    std::vector<std::shared_ptr<SimDrone>> fleet;
+    for (size_t d = 0; d < options.drones; ++d)
+    {
+        fleet.push_back(std::make_shared<SimDrone>(io_context, static_cast<int>(d + 1), options));
+        fleet.back()->connect();
+    }
+    std::thread io_thread([&io_context]()
+                          { io_context.run(); });
+
+    std::cout << "Initial connect:" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    double initial = wait_for_fleet(options.drones, start, 300.0);
+    std::cout << "  fleet up after " << initial << " s" << std::endl;
+
+    // Restart the server under the connected fleet
+    stop_server(server, reader);
+    admitted_sessions.store(0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.down_ms));
+    server = launch_server(options, reader);
+    auto restarted = std::chrono::steady_clock::now();
+
+    std::cout << "After restart:" << std::endl;
+    double recovery = wait_for_fleet(options.drones, restarted, 300.0);
+    if (recovery < 0)
+        std::cout << "  NOT recovered within 300 s (" << admitted_sessions.load() << "/" << options.drones << " admitted)" << std::endl;
+    else
+        std::cout << "Time to full recovery: " << recovery << " s" << std::endl;
+
+    stop_server(server, reader);
+    guard.reset();
+    io_context.stop();
+    io_thread.join();
+    return recovery < 0 ? 2 : 0;
+}
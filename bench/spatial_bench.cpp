@@ -0,0 +1,80 @@
+// Spatial index query times: radius, box and k-nearest queries, and the conflict scan.
+//
+// Places N drones uniformly over a square sized for about ten drones per 50 m cell
+// and times each query kind (median and worst of many runs). k-nearest is timed from a
+// drone inside the fleet and from a point far outside it, which used to fall back to
+// scanning every drone. The conflict scan is timed on the spread fleet and on the
+// same number of drones all at one spot (every drone still at its start position),
+// where it stops at the pair cap instead of producing n^2 pairs.
+//
+// Build: g++ -std=c++17 -O2 -I.. spatial_bench.cpp -o spatial_bench -lpthread
+// Run:   ./spatial_bench [drones] [runs]
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include "cc_spatial.hpp"
+
+template <typename Query>
+void time_query(const char *what, int runs, Query query)
+{
+    std::vector<double> us;
+    size_t results = 0;
+    for (int run = 0; run < runs; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        results = query(run);
+        us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(us.begin(), us.end());
+    std::cout << std::left << std::setw(30) << what << "median " << us[us.size() / 2] << " us, worst " << us.back()
+              << " us (" << results << " results)" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t drones = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    int runs = argc > 2 ? std::atoi(argv[2]) : 200;
+    double side = std::sqrt(drones / 10.0) * 50.0;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> coordinate(0.0, side);
+    cc::SpatialIndex spread(50.0);
+    std::vector<cc::DronePosition> positions;
+    for (size_t d = 0; d < drones; ++d)
+    {
+        positions.push_back(cc::DronePosition{static_cast<int>(d + 1), coordinate(rng), coordinate(rng)});
+        spread.submit(positions.back().drone_id, positions.back().x, positions.back().y);
+    }
+    spread.apply_pending();
+    std::cout << drones << " drones over " << side << " m x " << side << " m" << std::endl;
+
+    auto subject = [&](int run) -> const cc::DronePosition &
+    { return positions[static_cast<size_t>(run) * 7919 % positions.size()]; };
+    time_query("near, radius 100 m:", runs, [&](int run)
+               { return spread.within_radius(subject(run).x, subject(run).y, 100.0).size(); });
+    time_query("box, 200 m square:", runs, [&](int run)
+               { return spread.within_box(subject(run).x, subject(run).y, subject(run).x + 200.0, subject(run).y + 200.0).size(); });
+    time_query("knn, k 10, inside fleet:", runs, [&](int run)
+               { return spread.nearest(subject(run).x, subject(run).y, 10, subject(run).drone_id).size(); });
+    time_query("knn, k 10, 10 km outside:", runs, [&](int)
+               { return spread.nearest(side + 10000.0, side / 2, 10).size(); });
+    time_query("knn, k 1000, inside fleet:", runs, [&](int run)
+               { return spread.nearest(subject(run).x, subject(run).y, 1000).size(); });
+    time_query("conflicts 5 m, spread:", std::max(1, runs / 20), [&](int)
+               { return spread.conflicts(5.0).pairs.size(); });
+
+    cc::SpatialIndex crowd(50.0);
+    for (size_t d = 0; d < drones; ++d)
+        crowd.submit(static_cast<int>(d + 1), 0.0, 0.0);
+    crowd.apply_pending();
+    time_query("conflicts 5 m, one spot:", std::max(1, runs / 20), [&](int)
+               { return crowd.conflicts(5.0).pairs.size(); });
+    return 0;
+}
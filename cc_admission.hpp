@@ -0,0 +1,120 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <thread>
+#include <cerrno>
+#include <poll.h>
+
+// Server-side defences against reconnect storms: a deep listen backlog, accepting
+// connections in batches, and a token bucket that admits new sessions at a
+// bounded rate so a whole fleet reconnecting at once cannot swamp the handlers.
+namespace cc
+{
+    struct AdmissionOptions
+    {
+        int listen_backlog = 4096;    // Clamped by net.core.somaxconn
+        size_t accept_batch = 256;    // Connections drained from the backlog per wakeup
+        double admit_rate = 2000.0;   // New sessions admitted per second (0 = unlimited)
+        double admit_burst = 500.0;   // Sessions admitted back-to-back before the rate applies
+        size_t max_pending = 16384;   // Accepted-but-not-admitted sessions before accept pauses
+    };
+
+    class TokenBucket
+    {
+    public:
+        TokenBucket(double rate, double burst)
+            : rate_(rate), burst_(std::max(1.0, burst)), tokens_(std::max(1.0, burst)), last_(std::chrono::steady_clock::now()) {}
+
+        // Takes up to wanted tokens and returns how many were granted
+        size_t take(size_t wanted)
+        {
+            if (rate_ <= 0.0)
+                return wanted;
+            refill();
+            size_t granted = std::min(wanted, static_cast<size_t>(tokens_));
+            tokens_ -= static_cast<double>(granted);
+            return granted;
+        }
+
+        // Time until at least one token is available
+        std::chrono::microseconds wait_time()
+        {
+            if (rate_ <= 0.0)
+                return std::chrono::microseconds(0);
+            refill();
+            if (tokens_ >= 1.0)
+                return std::chrono::microseconds(0);
+            return std::chrono::microseconds(static_cast<long long>((1.0 - tokens_) / rate_ * 1e6) + 1);
+        }
+
+    private:
+        void refill()
+        {
+            auto now = std::chrono::steady_clock::now();
+            tokens_ = std::min(burst_, tokens_ + std::chrono::duration<double>(now - last_).count() * rate_);
+            last_ = now;
+        }
+
+        double rate_;
+        double burst_;
+        double tokens_;
+        std::chrono::steady_clock::time_point last_;
+    };
+
+    // Accept loop for a listening acceptor: wait for readiness, drain up to accept_batch
+    // connections without blocking, then hand them to admit(socket) as the token bucket
+    // allows. Runs until the acceptor fails.
+    template <typename Admit>
+    void run_batched_accept(boost::asio::ip::tcp::acceptor &acceptor, const AdmissionOptions &options, Admit admit)
+    {
+        using boost::asio::ip::tcp;
+        acceptor.non_blocking(true);
+        TokenBucket bucket(options.admit_rate, options.admit_burst);
+        std::deque<tcp::socket> pending;
+
+        while (true)
+        {
+            // Only block on the listening socket when nothing is waiting for admission
+            // (poll directly: asio's wait reports would_block on a non-blocking acceptor)
+            if (pending.empty())
+            {
+                pollfd ready{acceptor.native_handle(), POLLIN, 0};
+                if (::poll(&ready, 1, -1) < 0 && errno != EINTR)
+                    throw boost::system::system_error(errno, boost::system::system_category(), "poll");
+            }
+
+            for (size_t i = 0; i < options.accept_batch && pending.size() < options.max_pending; ++i)
+            {
+                boost::system::error_code error;
+                tcp::socket socket(acceptor.get_executor());
+                acceptor.accept(socket, error);
+                if (error == boost::asio::error::would_block || error == boost::asio::error::try_again)
+                    break;
+                if (error)
+                {
+                    // Per-connection failures (peer already gone, fd exhaustion) must not kill the acceptor
+                    std::cerr << "Accept error: " << error.message() << std::endl;
+                    if (error == boost::asio::error::no_descriptors)
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    break;
+                }
+                socket.non_blocking(false);
+                pending.push_back(std::move(socket));
+            }
+
+            size_t admitted = bucket.take(pending.size());
+            for (size_t i = 0; i < admitted; ++i)
+            {
+                admit(std::move(pending.front()));
+                pending.pop_front();
+            }
+
+            if (!pending.empty())
+                std::this_thread::sleep_for(std::min(bucket.wait_time(), std::chrono::microseconds(10000)));
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace cc
+{
+    // Pins the calling thread to one CPU core. A negative core leaves the thread unpinned.
+    inline bool pin_current_thread(int core, const std::string &name)
+    {
+        if (core < 0)
+            return true;
+
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core, &cpus);
+        int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (result != 0)
+        {
+            std::cerr << "Failed to pin " << name << " to core " << core << ": " << std::strerror(result) << std::endl;
+            return false;
+        }
+        std::cout << "Pinned " << name << " to core " << core << std::endl;
+        return true;
+    }
+}
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Live per-drone metrics derived incrementally from the telemetry stream.
+//
+// Every sample updates its drone's aggregates in O(1); nothing rescans history.
+// State is kept as a structure of arrays indexed by a dense per-drone slot, so a
+// fleet-wide rollup walks a handful of contiguous arrays in loops the compiler can
+// vectorise. Sliding windows are rings of time buckets per drone: a sample lands in
+// the bucket for its timestamp, and buckets that fall out of the window are
+// subtracted from running sums as the ring advances.
+namespace cc
+{
+    struct DroneMetrics
+    {
+        int drone_id = -1;
+        double x = 0.0;
+        double y = 0.0;
+        double speed = 0.0;           // Over the last sample interval, units per second
+        double window_speed = 0.0;    // Distance covered in the window / window length
+        double distance = 0.0;        // Since the first sample
+        double telemetry_rate = 0.0;  // Samples per second over the window
+        double interval = 0.0;        // Smoothed seconds between samples
+        double jitter = 0.0;          // Smoothed deviation of the interval, seconds
+        double since_telemetry = 0.0; // Seconds
+        double since_command = -1.0;  // Seconds, -1 if no command was ever sent
+        uint64_t samples = 0;
+    };
+
+    struct FleetRollup
+    {
+        size_t drones = 0;
+        size_t stale = 0; // No telemetry for longer than the stale threshold
+        size_t moving = 0;
+        double average_speed = 0.0; // Over drones that are not stale
+        double max_speed = 0.0;
+        double total_distance = 0.0;
+        double telemetry_rate = 0.0; // Samples per second across fresh drones
+    };
+
+    class DroneAnalytics
+    {
+    public:
+        static constexpr size_t window_buckets = 8;
+
+        // window: span of the sliding-window aggregates (rate, window speed)
+        explicit DroneAnalytics(uint64_t window_ns = 600000000000ull)
+            : bucket_ns_(std::max<uint64_t>(1, window_ns / window_buckets)) {}
+
+        void record_sample(int drone_id, double x, double y, uint64_t ts_ns)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t i = slot_of(drone_id);
+            int64_t ts = static_cast<int64_t>(ts_ns);
+
+            double step = 0.0;
+            if (samples_[i] > 0)
+            {
+                double dx = x - x_[i], dy = y - y_[i];
+                step = std::sqrt(dx * dx + dy * dy);
+                double dt = static_cast<double>(ts - last_seen_[i]) * 1e-9;
+                if (dt > 0.0)
+                {
+                    speed_[i] = step / dt;
+                    // Smoothed like RFC 3550 interarrival jitter (gain 1/16)
+                    if (samples_[i] == 1)
+                        interval_[i] = dt;
+                    jitter_[i] += (std::fabs(dt - interval_[i]) - jitter_[i]) / 16.0;
+                    interval_[i] += (dt - interval_[i]) / 16.0;
+                }
+                distance_[i] += step;
+            }
+            x_[i] = x;
+            y_[i] = y;
+            last_seen_[i] = std::max(last_seen_[i], ts);
+            samples_[i]++;
+
+            int64_t bucket = ts / static_cast<int64_t>(bucket_ns_);
+            advance(i, bucket);
+            if (bucket > head_bucket_[i] - static_cast<int64_t>(window_buckets))
+            {
+                size_t cell = i * window_buckets + static_cast<size_t>(bucket % window_buckets);
+                bucket_distance_[cell] += step;
+                bucket_samples_[cell]++;
+                window_samples_[i]++;
+            }
+        }
+
+        // Commands to a drone that has never reported are not tracked, so they add no slot
+        void record_command(int drone_id, uint64_t ts_ns)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t i;
+            if (find_slot(drone_id, i))
+                last_command_[i] = static_cast<int64_t>(ts_ns);
+        }
+
+        bool metrics_of(int drone_id, uint64_t now_ns, DroneMetrics &out) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t i;
+            if (!find_slot(drone_id, i) || samples_[i] == 0)
+                return false;
+
+            int64_t now = static_cast<int64_t>(now_ns);
+            out.drone_id = drone_id;
+            out.x = x_[i];
+            out.y = y_[i];
+            out.speed = speed_[i];
+            out.distance = distance_[i];
+            out.interval = interval_[i];
+            out.jitter = jitter_[i];
+            out.samples = samples_[i];
+            out.since_telemetry = static_cast<double>(now - last_seen_[i]) * 1e-9;
+            out.since_command = last_command_[i] < 0 ? -1.0 : static_cast<double>(now - last_command_[i]) * 1e-9;
+
+            // Only buckets still inside the window as of now count
+            int64_t now_bucket = now / static_cast<int64_t>(bucket_ns_);
+            double distance = 0.0;
+            uint64_t samples = 0;
+            for (int64_t b = std::max(head_bucket_[i] - static_cast<int64_t>(window_buckets) + 1, now_bucket - static_cast<int64_t>(window_buckets) + 1); b <= head_bucket_[i]; ++b)
+            {
+                size_t cell = i * window_buckets + static_cast<size_t>(b % window_buckets);
+                distance += bucket_distance_[cell];
+                samples += bucket_samples_[cell];
+            }
+            double window_s = static_cast<double>(bucket_ns_ * window_buckets) * 1e-9;
+            out.window_speed = distance / window_s;
+            out.telemetry_rate = static_cast<double>(samples) / window_s;
+            return true;
+        }
+
+        // Fleet-wide aggregates. The loop keeps `lanes` independent partial sums and
+        // uses no branches, so it vectorises without -ffast-math reassociation.
+        FleetRollup rollup(uint64_t now_ns, uint64_t stale_after_ns)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            FleetRollup result;
+            size_t n = ids_.size();
+            result.drones = n;
+            if (n == 0)
+                return result;
+
+            // Expire every ring to now first, so silent drones' old samples leave the rate
+            int64_t now_bucket = static_cast<int64_t>(now_ns) / static_cast<int64_t>(bucket_ns_);
+            for (size_t d = 0; d < n; ++d)
+                advance(d, now_bucket);
+
+            constexpr size_t lanes = 4;
+            const int64_t fresh_after = static_cast<int64_t>(now_ns) - static_cast<int64_t>(stale_after_ns);
+            const int64_t *seen = last_seen_.data();
+            const double *speed = speed_.data();
+            const double *distance = distance_.data();
+            const uint32_t *window = window_samples_.data();
+
+            double fresh[lanes] = {}, moving[lanes] = {}, speed_sum[lanes] = {}, max_speed[lanes] = {}, distance_sum[lanes] = {}, window_sum[lanes] = {};
+            size_t i = 0;
+            for (; i + lanes <= n; i += lanes)
+            {
+                for (size_t l = 0; l < lanes; ++l)
+                {
+                    double is_fresh = seen[i + l] >= fresh_after ? 1.0 : 0.0;
+                    double live_speed = speed[i + l] * is_fresh;
+                    fresh[l] += is_fresh;
+                    moving[l] += live_speed > 0.0 ? 1.0 : 0.0;
+                    speed_sum[l] += live_speed;
+                    max_speed[l] = max_speed[l] > live_speed ? max_speed[l] : live_speed;
+                    distance_sum[l] += distance[i + l];
+                    window_sum[l] += static_cast<double>(window[i + l]) * is_fresh;
+                }
+            }
+            for (; i < n; ++i)
+            {
+                double is_fresh = seen[i] >= fresh_after ? 1.0 : 0.0;
+                double live_speed = speed[i] * is_fresh;
+                fresh[0] += is_fresh;
+                moving[0] += live_speed > 0.0 ? 1.0 : 0.0;
+                speed_sum[0] += live_speed;
+                max_speed[0] = max_speed[0] > live_speed ? max_speed[0] : live_speed;
+                distance_sum[0] += distance[i];
+                window_sum[0] += static_cast<double>(window[i]) * is_fresh;
+            }
+
+            double total_fresh = 0.0, total_moving = 0.0, total_speed = 0.0, total_window = 0.0;
+            for (size_t l = 0; l < lanes; ++l)
+            {
+                total_fresh += fresh[l];
+                total_moving += moving[l];
+                total_speed += speed_sum[l];
+                total_window += window_sum[l];
+                result.total_distance += distance_sum[l];
+                result.max_speed = std::max(result.max_speed, max_speed[l]);
+            }
+            result.stale = n - static_cast<size_t>(total_fresh);
+            result.moving = static_cast<size_t>(total_moving);
+            result.average_speed = total_fresh > 0.0 ? total_speed / total_fresh : 0.0;
+            result.telemetry_rate = total_window / (static_cast<double>(bucket_ns_ * window_buckets) * 1e-9);
+            return result;
+        }
+
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return ids_.size();
+        }
+
+    private:
+        // Small non-negative ids index a flat table; anything else goes through a hash map
+        static constexpr int dense_ids = 1 << 20;
+
+        bool find_slot(int drone_id, size_t &slot) const
+        {
+            if (drone_id >= 0 && drone_id < dense_ids)
+            {
+                if (static_cast<size_t>(drone_id) >= dense_slot_.size() || dense_slot_[drone_id] < 0)
+                    return false;
+                slot = static_cast<size_t>(dense_slot_[drone_id]);
+                return true;
+            }
+            auto it = sparse_slot_.find(drone_id);
+            if (it == sparse_slot_.end())
+                return false;
+            slot = it->second;
+            return true;
+        }
+
+        // Moves a slot's ring head to bucket, subtracting the buckets that fall out of the window
+        void advance(size_t i, int64_t bucket)
+        {
+            int64_t head = head_bucket_[i];
+            if (bucket <= head)
+                return;
+            size_t base = i * window_buckets;
+            int64_t expire = std::min<int64_t>(bucket - head, window_buckets);
+            for (int64_t b = 1; b <= expire; ++b)
+            {
+                size_t cell = base + static_cast<size_t>((head + b) % window_buckets);
+                window_samples_[i] -= bucket_samples_[cell];
+                bucket_distance_[cell] = 0.0;
+                bucket_samples_[cell] = 0;
+            }
+            head_bucket_[i] = bucket;
+        }
+
+        size_t slot_of(int drone_id)
+        {
+            size_t slot;
+            if (find_slot(drone_id, slot))
+                return slot;
+
+            slot = ids_.size();
+            if (drone_id >= 0 && drone_id < dense_ids)
+            {
+                if (static_cast<size_t>(drone_id) >= dense_slot_.size())
+                    dense_slot_.resize(std::max<size_t>(static_cast<size_t>(drone_id) + 1, dense_slot_.size() * 2), -1);
+                dense_slot_[drone_id] = static_cast<int32_t>(slot);
+            }
+            else
+            {
+                sparse_slot_[drone_id] = slot;
+            }
+
+            ids_.push_back(drone_id);
+            x_.push_back(0.0);
+            y_.push_back(0.0);
+            speed_.push_back(0.0);
+            distance_.push_back(0.0);
+            interval_.push_back(0.0);
+            jitter_.push_back(0.0);
+            last_seen_.push_back(0);
+            last_command_.push_back(-1);
+            samples_.push_back(0);
+            head_bucket_.push_back(0);
+            window_samples_.push_back(0);
+            bucket_distance_.resize(bucket_distance_.size() + window_buckets, 0.0);
+            bucket_samples_.resize(bucket_samples_.size() + window_buckets, 0);
+            return slot;
+        }
+
+        uint64_t bucket_ns_;
+        mutable std::mutex mutex_;
+
+        std::vector<int32_t> dense_slot_;
+        std::unordered_map<int, size_t> sparse_slot_;
+
+        // One array per field, indexed by slot
+        std::vector<int> ids_;
+        std::vector<double> x_, y_, speed_, distance_, interval_, jitter_;
+        std::vector<int64_t> last_seen_, last_command_;
+        std::vector<uint32_t> samples_;
+
+        // Sliding window: a running sample count plus window_buckets consecutive cells per slot
+        std::vector<int64_t> head_bucket_;
+        std::vector<uint32_t> window_samples_;
+        std::vector<double> bucket_distance_;
+        std::vector<uint32_t> bucket_samples_;
+    };
+}
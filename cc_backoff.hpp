@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace cc
+{
+    // Decorrelated-jitter exponential backoff for reconnect loops:
+    //   sleep = min(cap, random_between(base, previous_sleep * 3))
+    // Each drone draws its own random sequence, so a fleet that lost the server at the
+    // same instant spreads its reconnects out instead of retrying in lockstep.
+    class DecorrelatedJitter
+    {
+    public:
+        DecorrelatedJitter(std::chrono::milliseconds base, std::chrono::milliseconds cap, unsigned seed = std::random_device{}())
+            : base_(base.count()), cap_(cap.count()), previous_(base.count()), rng_(seed) {}
+
+        std::chrono::milliseconds next()
+        {
+            long long upper = std::max(base_, std::min(cap_, previous_ * 3));
+            std::uniform_int_distribution<long long> pick(base_, upper);
+            previous_ = std::min(cap_, pick(rng_));
+            return std::chrono::milliseconds(previous_);
+        }
+
+        // Call after a successful connection so the next outage starts from base again
+        void reset() { previous_ = base_; }
+
+    private:
+        long long base_;
+        long long cap_;
+        long long previous_;
+        std::mt19937 rng_;
+    };
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Binary capture of the server's telemetry, command and file channels.
+//
+// File layout (host byte order, little-endian on every target we run on):
+//   header : "CCAP" | u32 version | u64 wall-clock start (ns since epoch)
+//   record : u64 ts_ns | u32 session | u32 length | u16 port | u8 channel | u8 kind | payload[length]
+//
+// ts_ns is measured on the steady clock from the moment the capture was opened,
+// so a replay can reproduce the original pacing. Payloads are stored exactly as
+// they crossed the wire (still encrypted where the link encrypts).
+namespace cc
+{
+    enum class CaptureChannel : uint8_t
+    {
+        Telemetry = 0,
+        Command = 1,
+        File = 2
+    };
+
+    enum class CaptureKind : uint8_t
+    {
+        Open = 0,
+        Data = 1,
+        Close = 2
+    };
+
+#pragma pack(push, 1)
+    struct CaptureRecordHeader
+    {
+        uint64_t ts_ns;
+        uint32_t session;
+        uint32_t length;
+        uint16_t port;
+        uint8_t channel;
+        uint8_t kind;
+    };
+#pragma pack(pop)
+
+    static_assert(sizeof(CaptureRecordHeader) == 20, "capture record header must stay 20 bytes");
+
+    constexpr char capture_magic[4] = {'C', 'C', 'A', 'P'};
+    constexpr uint32_t capture_version = 1;
+
+    // Thread-safe recorder shared by all server threads. Records are staged in an
+    // in-memory batch and written out in large blocks to keep the taps cheap.
+    class CaptureWriter
+    {
+    public:
+        ~CaptureWriter() { close(); }
+
+        bool open(const std::string &path)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            out_.open(path, std::ios::binary | std::ios::trunc);
+            if (!out_)
+                return false;
+
+            start_ = std::chrono::steady_clock::now();
+            uint64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::system_clock::now().time_since_epoch())
+                                   .count();
+            out_.write(capture_magic, sizeof(capture_magic));
+            out_.write(reinterpret_cast<const char *>(&capture_version), sizeof(capture_version));
+            out_.write(reinterpret_cast<const char *>(&wall_ns), sizeof(wall_ns));
+            out_.flush();
+            batch_.reserve(batch_limit);
+            enabled_.store(true);
+            return true;
+        }
+
+        bool is_open() const { return enabled_.load(std::memory_order_relaxed); }
+
+        // Allocates a session id for a new connection (or command stream) and logs its opening.
+        uint32_t open_session(CaptureChannel channel, uint16_t port)
+        {
+            uint32_t session = next_session_.fetch_add(1);
+            append(session, channel, CaptureKind::Open, port, nullptr, 0);
+            return session;
+        }
+
+        void data(uint32_t session, CaptureChannel channel, uint16_t port, const char *payload, size_t length)
+        {
+            append(session, channel, CaptureKind::Data, port, payload, length);
+        }
+
+        void close_session(uint32_t session, CaptureChannel channel, uint16_t port)
+        {
+            append(session, channel, CaptureKind::Close, port, nullptr, 0);
+        }
+
+        void flush()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            flush_locked();
+        }
+
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!enabled_.exchange(false))
+                return;
+            flush_locked();
+            out_.close();
+        }
+
+    private:
+        static constexpr size_t batch_limit = 64 * 1024;
+        static constexpr uint64_t flush_interval_ns = 1000000000ull;
+
+        void append(uint32_t session, CaptureChannel channel, CaptureKind kind, uint16_t port, const char *payload, size_t length)
+        {
+            if (!is_open())
+                return;
+
+            // Timestamp under the lock so records are in file order and ts_ns never goes backwards.
+            std::lock_guard<std::mutex> lock(mutex_);
+            CaptureRecordHeader header;
+            header.ts_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+            header.session = session;
+            header.length = static_cast<uint32_t>(length);
+            header.port = port;
+            header.channel = static_cast<uint8_t>(channel);
+            header.kind = static_cast<uint8_t>(kind);
+
+            const char *raw = reinterpret_cast<const char *>(&header);
+            batch_.insert(batch_.end(), raw, raw + sizeof(header));
+            if (length > 0)
+                batch_.insert(batch_.end(), payload, payload + length);
+
+            // Open/close markers are rare and important for replay, so make them durable promptly.
+            // Slow streams are flushed at least once a second so a crash loses little.
+            if (batch_.size() >= batch_limit || kind != CaptureKind::Data || header.ts_ns - last_flush_ns_ >= flush_interval_ns)
+            {
+                flush_locked();
+                last_flush_ns_ = header.ts_ns;
+            }
+        }
+
+        void flush_locked()
+        {
+            if (!batch_.empty())
+            {
+                out_.write(batch_.data(), batch_.size());
+                batch_.clear();
+            }
+            out_.flush();
+        }
+
+        std::mutex mutex_;
+        std::ofstream out_;
+        std::vector<char> batch_;
+        std::chrono::steady_clock::time_point start_;
+        uint64_t last_flush_ns_ = 0;
+        std::atomic<bool> enabled_{false};
+        std::atomic<uint32_t> next_session_{1};
+    };
+
+    // Sequential reader used by the replay tool.
+    class CaptureReader
+    {
+    public:
+        bool open(const std::string &path)
+        {
+            in_.open(path, std::ios::binary);
+            if (!in_)
+                return false;
+
+            char magic[4];
+            uint32_t version = 0;
+            in_.read(magic, sizeof(magic));
+            in_.read(reinterpret_cast<char *>(&version), sizeof(version));
+            in_.read(reinterpret_cast<char *>(&wall_start_ns_), sizeof(wall_start_ns_));
+            return in_ && std::memcmp(magic, capture_magic, sizeof(magic)) == 0 && version == capture_version;
+        }
+
+        // Returns false at end of file or on a truncated trailing record.
+        bool next(CaptureRecordHeader &header, std::string &payload)
+        {
+            if (!in_.read(reinterpret_cast<char *>(&header), sizeof(header)))
+                return false;
+            payload.resize(header.length);
+            if (header.length > 0 && !in_.read(&payload[0], header.length))
+                return false;
+            return true;
+        }
+
+        uint64_t wall_start_ns() const { return wall_start_ns_; }
+
+    private:
+        std::ifstream in_;
+        uint64_t wall_start_ns_ = 0;
+    };
+}
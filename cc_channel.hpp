@@ -0,0 +1,348 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "cc_commands.hpp"
+#include "cc_lowlatency.hpp"
+
+// Wire channels composed at compile time from four policies:
+//
+//   Transport  moves bytes          TcpStream, UdpDatagram
+//   Framing    delimits messages    LineFraming (newline-terminated), DatagramFraming
+//                                   (one message per datagram), RawFraming (byte stream)
+//   Cipher     link encryption      NoCipher, XorCipher<Key>
+//   Codec      message <-> bytes    StringCodec (text lines, file chunks), CommandCodec
+//
+// Channel<Transport, Framing, Cipher, Codec> calls its policies only through static
+// or non-virtual members, so every configuration compiles to its own inlined send
+// and receive path: an identity cipher or codec disappears entirely. The send and
+// receive buffers belong to the channel and are reused for every message.
+//
+// Sending: Codec::encode -> Cipher::apply -> Framing::frame -> Transport::write.
+// Receiving runs the same steps backwards. The cipher is applied to the payload
+// only, never to the frame delimiter.
+namespace cc
+{
+    // One received frame inside the channel's receive buffer, valid until the next receive
+    struct Frame
+    {
+        char *data = nullptr;
+        size_t size = 0;      // Payload bytes
+        size_t wire_size = 0; // Bytes taken off the wire, including any delimiter
+    };
+
+    // Receive storage shared by the framing policies: bytes [begin, end) are unconsumed
+    struct ReceiveBuffer
+    {
+        std::vector<char> bytes;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    // ---- Transports
+
+    class TcpStream
+    {
+    public:
+        explicit TcpStream(boost::asio::io_context &io_context) : socket_(io_context) {}
+        explicit TcpStream(boost::asio::ip::tcp::socket socket) : socket_(std::move(socket)) {}
+
+        boost::asio::ip::tcp::socket &socket() { return socket_; }
+
+        size_t write(const char *data, size_t size, boost::system::error_code &error)
+        {
+            return boost::asio::write(socket_, boost::asio::buffer(data, size), error);
+        }
+
+        size_t read_some(char *data, size_t capacity, boost::system::error_code &error)
+        {
+            return socket_.read_some(boost::asio::buffer(data, capacity), error);
+        }
+
+    private:
+        boost::asio::ip::tcp::socket socket_;
+    };
+
+    // Sends to a fixed peer; receives from anyone (see sender()). Receives honour the
+    // control channel's latency options, so a busy-poll socket spins here.
+    class UdpDatagram
+    {
+    public:
+        explicit UdpDatagram(boost::asio::ip::udp::socket socket,
+                             boost::asio::ip::udp::endpoint peer = boost::asio::ip::udp::endpoint(),
+                             ControlLatencyOptions latency = ControlLatencyOptions())
+            : socket_(std::move(socket)), peer_(peer), latency_(latency) {}
+
+        boost::asio::ip::udp::socket &socket() { return socket_; }
+        const boost::asio::ip::udp::endpoint &sender() const { return sender_; }
+        void set_peer(const boost::asio::ip::udp::endpoint &peer) { peer_ = peer; }
+
+        size_t write(const char *data, size_t size, boost::system::error_code &error)
+        {
+            return socket_.send_to(boost::asio::buffer(data, size), peer_, 0, error);
+        }
+
+        size_t read_some(char *data, size_t capacity, boost::system::error_code &error)
+        {
+            return receive_control_datagram(socket_, boost::asio::buffer(data, capacity), sender_, latency_, error);
+        }
+
+    private:
+        boost::asio::ip::udp::socket socket_;
+        boost::asio::ip::udp::endpoint peer_;
+        boost::asio::ip::udp::endpoint sender_;
+        ControlLatencyOptions latency_;
+    };
+
+    // ---- Framing
+
+    // Newline-terminated messages over a byte stream
+    struct LineFraming
+    {
+        static constexpr bool delimited = true;
+
+        static void frame(std::string &wire) { wire.push_back('\n'); }
+
+        // Returns the next complete line, reading more from the transport as needed.
+        // A partial line at end of stream is dropped, as with read_until.
+        template <typename Transport>
+        static bool next(Transport &transport, ReceiveBuffer &buffer, Frame &frame, boost::system::error_code &error)
+        {
+            size_t scanned = buffer.begin;
+            while (true)
+            {
+                char *start = buffer.bytes.data() + buffer.begin;
+                char *newline = static_cast<char *>(std::memchr(buffer.bytes.data() + scanned, '\n', buffer.end - scanned));
+                if (newline)
+                {
+                    frame.data = start;
+                    frame.size = static_cast<size_t>(newline - start);
+                    frame.wire_size = frame.size + 1;
+                    buffer.begin += frame.wire_size;
+                    return true;
+                }
+
+                // Make room: slide the partial line to the front, or grow if it fills the buffer
+                if (buffer.begin > 0)
+                {
+                    std::memmove(buffer.bytes.data(), start, buffer.end - buffer.begin);
+                    buffer.end -= buffer.begin;
+                    buffer.begin = 0;
+                }
+                if (buffer.end == buffer.bytes.size())
+                    buffer.bytes.resize(buffer.bytes.size() * 2);
+                scanned = buffer.end;
+
+                size_t length = transport.read_some(buffer.bytes.data() + buffer.end, buffer.bytes.size() - buffer.end, error);
+                if (error)
+                    return false;
+                buffer.end += length;
+            }
+        }
+
+        // Splits bytes received by other means (e.g. an event-driven read) into lines.
+        // on_line(std::string) gets each complete line; an unterminated tail stays in carry.
+        template <typename Handler>
+        static void split(std::string &carry, const char *data, size_t size, Handler on_line)
+        {
+            const char *end = data + size;
+            while (data < end)
+            {
+                const char *newline = static_cast<const char *>(std::memchr(data, '\n', end - data));
+                if (!newline)
+                {
+                    carry.append(data, end - data);
+                    return;
+                }
+
+                std::string line;
+                if (carry.empty())
+                {
+                    line.assign(data, newline);
+                }
+                else
+                {
+                    line = std::move(carry);
+                    line.append(data, newline);
+                    carry = std::string();
+                }
+                on_line(std::move(line));
+                data = newline + 1;
+            }
+        }
+    };
+
+    // One message per datagram
+    struct DatagramFraming
+    {
+        static constexpr bool delimited = false;
+
+        static void frame(std::string &) {}
+
+        template <typename Transport>
+        static bool next(Transport &transport, ReceiveBuffer &buffer, Frame &frame, boost::system::error_code &error)
+        {
+            size_t length = transport.read_some(buffer.bytes.data(), buffer.bytes.size(), error);
+            if (error)
+                return false;
+            frame.data = buffer.bytes.data();
+            frame.size = frame.wire_size = length;
+            return true;
+        }
+    };
+
+    // Unframed byte stream (file transfers): each read is a frame
+    struct RawFraming
+    {
+        static constexpr bool delimited = false;
+
+        static void frame(std::string &) {}
+
+        template <typename Transport>
+        static bool next(Transport &transport, ReceiveBuffer &buffer, Frame &frame, boost::system::error_code &error)
+        {
+            return DatagramFraming::next(transport, buffer, frame, error);
+        }
+    };
+
+    // ---- Ciphers
+
+    struct NoCipher
+    {
+        static constexpr bool identity = true;
+        static void apply(char *, size_t) {}
+    };
+
+    // Symmetric single-byte XOR, as used by the encrypted server/drone pair
+    template <char Key>
+    struct XorCipher
+    {
+        static constexpr bool identity = false;
+        static void apply(char *data, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+                data[i] ^= Key;
+        }
+    };
+
+    // ---- Codecs
+
+    // Messages are byte strings: telemetry lines or file chunks
+    struct StringCodec
+    {
+        typedef std::string Message;
+        static constexpr bool identity = true;
+
+        static void encode(const std::string &message, std::string &wire) { wire.append(message); }
+
+        static bool decode(const char *data, size_t size, std::string &message, std::string *)
+        {
+            message.assign(data, size);
+            return true;
+        }
+    };
+
+    // Binary control commands (see cc_commands.hpp)
+    struct CommandCodec
+    {
+        typedef Command Message;
+        static constexpr bool identity = false;
+
+        static void encode(const Command &command, std::string &wire) { encode_command(command, wire); }
+
+        static bool decode(const char *data, size_t size, Command &command, std::string *error)
+        {
+            return decode_command(data, size, command, error);
+        }
+    };
+
+    template <typename Transport, typename Framing, typename Cipher, typename Codec>
+    class Channel
+    {
+    public:
+        typedef typename Codec::Message Message;
+        typedef Framing framing;
+        typedef Cipher cipher;
+
+        // transport is a Transport or anything one can be built from (an io_context, a socket)
+        template <typename TransportArg>
+        explicit Channel(TransportArg &&transport, size_t buffer_size = 4096) : transport_(std::forward<TransportArg>(transport))
+        {
+            in_.bytes.resize(buffer_size > 0 ? buffer_size : 1);
+        }
+
+        Transport &transport() { return transport_; }
+
+        // Encodes, enciphers, frames and writes one message. Returns bytes written.
+        size_t send(const Message &message, boost::system::error_code &error)
+        {
+            // Nothing to transform: write straight from the caller's bytes
+            if constexpr (Codec::identity && Cipher::identity && !Framing::delimited)
+                return transport_.write(message.data(), message.size(), error);
+
+            out_.clear();
+            Codec::encode(message, out_);
+            Cipher::apply(&out_[0], out_.size());
+            Framing::frame(out_);
+            return transport_.write(out_.data(), out_.size(), error);
+        }
+
+        // Sends a span of bytes as one message, for byte-string channels (e.g. file chunks
+        // straight out of a FileSource); copies only if the cipher or framing must touch it
+        size_t send(const char *data, size_t size, boost::system::error_code &error)
+        {
+            static_assert(std::is_same<Message, std::string>::value && Codec::identity, "byte spans need a byte-string codec");
+            if constexpr (Cipher::identity && !Framing::delimited)
+                return transport_.write(data, size, error);
+
+            out_.assign(data, size);
+            Cipher::apply(&out_[0], out_.size());
+            Framing::frame(out_);
+            return transport_.write(out_.data(), out_.size(), error);
+        }
+
+        // The bytes the last send() put on the wire (empty when it wrote the caller's bytes directly)
+        const std::string &sent() const { return out_; }
+
+        // The next frame exactly as received, still enciphered (what a capture records)
+        bool receive_frame(Frame &frame, boost::system::error_code &error)
+        {
+            return Framing::next(transport_, in_, frame, error);
+        }
+
+        // Deciphers a frame's payload in place and decodes it
+        static bool open(Frame &frame, Message &message, std::string *decode_error = nullptr)
+        {
+            Cipher::apply(frame.data, frame.size);
+            return Codec::decode(frame.data, frame.size, message, decode_error);
+        }
+
+        // receive_frame + open. Returns false with error set if the transport failed,
+        // or with error clear if the frame did not decode.
+        bool receive(Message &message, boost::system::error_code &error, std::string *decode_error = nullptr)
+        {
+            Frame frame;
+            if (!receive_frame(frame, error))
+                return false;
+            return open(frame, message, decode_error);
+        }
+
+        // Unframed channels only: reads straight into the caller's buffer and deciphers in place
+        size_t receive_into(char *buffer, size_t capacity, boost::system::error_code &error)
+        {
+            static_assert(!Framing::delimited, "receive_into bypasses message framing");
+            size_t length = transport_.read_some(buffer, capacity, error);
+            Cipher::apply(buffer, length);
+            return length;
+        }
+
+    private:
+        Transport transport_;
+        ReceiveBuffer in_;
+        std::string out_;
+    };
+}
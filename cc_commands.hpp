@@ -0,0 +1,323 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// Control command schema shared by the server and the drones.
+//
+// Every command is one entry in command_table. The entry drives everything else:
+// text parsing on the server, the binary wire codec, argument validation and the
+// drone-side jump table. Adding a command means adding an Opcode and one entry.
+//
+// Wire format (one UDP datagram per command, before any link cipher):
+//   u8 opcode | u32 id | f32 arg[0] | ... | f32 arg[argc-1]      (host byte order)
+// The id is assigned by the server and echoed back in telemetry for latency tracing.
+// Optional arguments are always present on the wire, filled with their defaults,
+// so the encoded size of each opcode is fixed and checked on decode.
+namespace cc
+{
+    // State a drone mutates when it applies a command
+    struct DroneState
+    {
+        double x = 0.0;
+        double y = 0.0;
+        double altitude = 0.0;
+        double speed = 1.0;    // Metres per unit of move distance
+        bool hovering = false; // Holding position: moves and goto are ignored
+    };
+
+    enum class Opcode : uint8_t
+    {
+        MoveFront = 0,
+        MoveBack,
+        MoveLeft,
+        MoveRight,
+        Goto,
+        SetSpeed,
+        Hover,
+        Count
+    };
+
+    constexpr size_t max_command_args = 3;
+
+    struct Command
+    {
+        Opcode op = Opcode::Hover;
+        uint32_t id = 0;
+        std::array<float, max_command_args> args{};
+    };
+
+    // A typed argument: its name (for usage text), accepted range and default when omitted
+    struct ArgSpec
+    {
+        std::string_view name;
+        float min;
+        float max;
+        float fallback;
+    };
+
+    constexpr ArgSpec distance_arg{"distance", 0.0f, 1000.0f, 1.0f};
+    constexpr ArgSpec x_arg{"x", -100000.0f, 100000.0f, 0.0f};
+    constexpr ArgSpec y_arg{"y", -100000.0f, 100000.0f, 0.0f};
+    constexpr ArgSpec altitude_arg{"alt", 0.0f, 5000.0f, 0.0f};
+    constexpr ArgSpec speed_arg{"speed", 0.1f, 50.0f, 1.0f};
+    constexpr ArgSpec hover_arg{"on", 0.0f, 1.0f, 1.0f};
+    constexpr ArgSpec no_arg{"", 0.0f, 0.0f, 0.0f};
+
+    using CommandHandler = void (*)(DroneState &, const Command &);
+
+    struct CommandSpec
+    {
+        Opcode op;
+        std::string_view name;
+        uint8_t required; // Arguments that must be given in text form
+        uint8_t argc;     // Arguments carried on the wire
+        std::array<ArgSpec, max_command_args> args;
+        CommandHandler apply;
+    };
+
+    // Moves cover distance x speed: speed is the step size, so "speed 5" then "move front 2"
+    // goes 10 m. While hovering the drone holds its position and ignores moves and goto
+    // until "hover 0" releases it.
+    namespace handlers
+    {
+        inline void move_front(DroneState &s, const Command &c)
+        {
+            if (!s.hovering)
+                s.y += c.args[0] * s.speed;
+        }
+        inline void move_back(DroneState &s, const Command &c)
+        {
+            if (!s.hovering)
+                s.y -= c.args[0] * s.speed;
+        }
+        inline void move_left(DroneState &s, const Command &c)
+        {
+            if (!s.hovering)
+                s.x -= c.args[0] * s.speed;
+        }
+        inline void move_right(DroneState &s, const Command &c)
+        {
+            if (!s.hovering)
+                s.x += c.args[0] * s.speed;
+        }
+        inline void go_to(DroneState &s, const Command &c)
+        {
+            if (s.hovering)
+                return;
+            s.x = c.args[0];
+            s.y = c.args[1];
+            s.altitude = c.args[2];
+        }
+        inline void set_speed(DroneState &s, const Command &c) { s.speed = c.args[0]; }
+        inline void hover(DroneState &s, const Command &c) { s.hovering = c.args[0] != 0.0f; }
+    }
+
+    // The schema. Entries must stay in Opcode order: the table doubles as the dispatch jump table.
+    inline constexpr std::array<CommandSpec, static_cast<size_t>(Opcode::Count)> command_table{{
+        {Opcode::MoveFront, "move front", 0, 1, {distance_arg, no_arg, no_arg}, handlers::move_front},
+        {Opcode::MoveBack, "move back", 0, 1, {distance_arg, no_arg, no_arg}, handlers::move_back},
+        {Opcode::MoveLeft, "move left", 0, 1, {distance_arg, no_arg, no_arg}, handlers::move_left},
+        {Opcode::MoveRight, "move right", 0, 1, {distance_arg, no_arg, no_arg}, handlers::move_right},
+        {Opcode::Goto, "goto", 2, 3, {x_arg, y_arg, altitude_arg}, handlers::go_to},
+        {Opcode::SetSpeed, "speed", 1, 1, {speed_arg, no_arg, no_arg}, handlers::set_speed},
+        {Opcode::Hover, "hover", 0, 1, {hover_arg, no_arg, no_arg}, handlers::hover},
+    }};
+
+    constexpr bool command_table_is_ordered()
+    {
+        for (size_t i = 0; i < command_table.size(); ++i)
+        {
+            if (static_cast<size_t>(command_table[i].op) != i || command_table[i].required > command_table[i].argc ||
+                command_table[i].argc > max_command_args || command_table[i].apply == nullptr)
+                return false;
+        }
+        return true;
+    }
+    static_assert(command_table_is_ordered(), "command_table entries must be in Opcode order with valid arity");
+
+    constexpr const CommandSpec &command_spec(Opcode op) { return command_table[static_cast<size_t>(op)]; }
+
+    constexpr size_t command_header_size = 1 + sizeof(uint32_t);
+
+    constexpr size_t encoded_size(Opcode op) { return command_header_size + sizeof(float) * command_spec(op).argc; }
+
+    constexpr size_t max_encoded_command_size()
+    {
+        size_t size = 0;
+        for (const auto &spec : command_table)
+            size = encoded_size(spec.op) > size ? encoded_size(spec.op) : size;
+        return size;
+    }
+
+    inline bool validate_command(const Command &command, std::string *error = nullptr)
+    {
+        if (command.op >= Opcode::Count)
+        {
+            if (error)
+                *error = "unknown opcode " + std::to_string(static_cast<int>(command.op));
+            return false;
+        }
+
+        const CommandSpec &spec = command_spec(command.op);
+        for (size_t i = 0; i < spec.argc; ++i)
+        {
+            float value = command.args[i];
+            if (!std::isfinite(value) || value < spec.args[i].min || value > spec.args[i].max)
+            {
+                if (error)
+                {
+                    std::ostringstream message;
+                    message << std::string(spec.name) << ": " << std::string(spec.args[i].name) << " must be in ["
+                            << spec.args[i].min << ", " << spec.args[i].max << "]";
+                    *error = message.str();
+                }
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Appends the encoded command to wire (lets a caller reuse one send buffer)
+    inline void encode_command(const Command &command, std::string &wire)
+    {
+        const CommandSpec &spec = command_spec(command.op);
+        size_t start = wire.size();
+        wire.resize(start + encoded_size(command.op));
+        wire[start] = static_cast<char>(command.op);
+        std::memcpy(&wire[start + 1], &command.id, sizeof(command.id));
+        std::memcpy(&wire[start + command_header_size], command.args.data(), sizeof(float) * spec.argc);
+    }
+
+    inline std::string encode_command(const Command &command)
+    {
+        std::string wire;
+        encode_command(command, wire);
+        return wire;
+    }
+
+    // Decodes and validates one datagram. Anything malformed is rejected rather than guessed at.
+    inline bool decode_command(const char *data, size_t length, Command &command, std::string *error = nullptr)
+    {
+        if (length == 0 || static_cast<uint8_t>(data[0]) >= static_cast<uint8_t>(Opcode::Count))
+        {
+            if (error)
+                *error = length == 0 ? "empty command" : "unknown opcode " + std::to_string(static_cast<uint8_t>(data[0]));
+            return false;
+        }
+
+        command = Command{};
+        command.op = static_cast<Opcode>(data[0]);
+        if (length != encoded_size(command.op))
+        {
+            if (error)
+                *error = "bad length " + std::to_string(length) + " for " + std::string(command_spec(command.op).name);
+            return false;
+        }
+        std::memcpy(&command.id, data + 1, sizeof(command.id));
+        std::memcpy(command.args.data(), data + command_header_size, sizeof(float) * command_spec(command.op).argc);
+        return validate_command(command, error);
+    }
+
+    // Parses operator input such as "move front", "move left 5" or "goto 10 20 30".
+    inline bool parse_command(std::string_view text, Command &command, std::string *error = nullptr)
+    {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r' || text.back() == '\n'))
+            text.remove_suffix(1);
+
+        // Longest matching name wins, and it must be followed by a separator or the end
+        const CommandSpec *match = nullptr;
+        for (const auto &spec : command_table)
+        {
+            if (text.substr(0, spec.name.size()) == spec.name &&
+                (text.size() == spec.name.size() || text[spec.name.size()] == ' ') &&
+                (!match || spec.name.size() > match->name.size()))
+                match = &spec;
+        }
+        if (!match)
+        {
+            if (error)
+                *error = "unknown command";
+            return false;
+        }
+
+        command = Command{};
+        command.op = match->op;
+        std::string rest(text.substr(match->name.size()));
+        std::istringstream args(rest);
+        size_t given = 0;
+        std::string token;
+        while (args >> token)
+        {
+            if (given == match->argc)
+            {
+                if (error)
+                    *error = std::string(match->name) + ": too many arguments";
+                return false;
+            }
+            char *end = nullptr;
+            command.args[given] = std::strtof(token.c_str(), &end);
+            if (end == token.c_str() || *end != '\0')
+            {
+                if (error)
+                    *error = std::string(match->name) + ": '" + token + "' is not a number";
+                return false;
+            }
+            ++given;
+        }
+        if (given < match->required)
+        {
+            if (error)
+                *error = std::string(match->name) + ": missing arguments";
+            return false;
+        }
+        for (size_t i = given; i < match->argc; ++i)
+            command.args[i] = match->args[i].fallback;
+
+        return validate_command(command, error);
+    }
+
+    inline std::string format_command(const Command &command)
+    {
+        const CommandSpec &spec = command_spec(command.op);
+        std::ostringstream text;
+        text << std::string(spec.name);
+        for (size_t i = 0; i < spec.argc; ++i)
+            text << ' ' << command.args[i];
+        return text.str();
+    }
+
+    // Usage line generated from the schema, e.g. "move front [distance], goto <x> <y> [alt], ..."
+    inline std::string command_usage()
+    {
+        std::string usage;
+        for (const auto &spec : command_table)
+        {
+            if (!usage.empty())
+                usage += ", ";
+            usage += std::string(spec.name);
+            for (size_t i = 0; i < spec.argc; ++i)
+            {
+                bool optional = i >= spec.required;
+                usage += optional ? " [" : " <";
+                usage += std::string(spec.args[i].name);
+                usage += optional ? "]" : ">";
+            }
+        }
+        return usage;
+    }
+
+    // Dispatch through the schema's jump table. The command must already be validated.
+    inline void apply_command(DroneState &state, const Command &command)
+    {
+        command_table[static_cast<size_t>(command.op)].apply(state, command);
+    }
+}
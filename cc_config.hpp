@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Startup configuration shared by the drone and server binaries.
+//
+// Settings come from an optional config file of "key = value" lines ('#' starts a
+// comment) and then from the command line as "--key value", "--key=value" or a bare
+// "--flag" (= true), so the command line wins. Dashes and underscores in keys are
+// interchangeable: --queue-depth and queue_depth are the same setting. The file is
+// read with a single fread and parsed in one pass.
+namespace cc
+{
+    class Config
+    {
+    public:
+        // Loads --config <path> (if given) and then every other --key from argv.
+        // Returns false, with error set, if the config file cannot be read.
+        bool load(int argc, char *argv[], std::string *error = nullptr)
+        {
+            for (int i = 1; i + 1 < argc; ++i)
+            {
+                if (std::strcmp(argv[i], "--config") == 0 && !load_file(argv[i + 1], error))
+                    return false;
+            }
+
+            for (int i = 1; i < argc; ++i)
+            {
+                if (std::strncmp(argv[i], "--", 2) != 0)
+                    continue;
+                std::string key = argv[i] + 2;
+                std::string value = "true";
+                size_t equals = key.find('=');
+                if (equals != std::string::npos)
+                {
+                    value = key.substr(equals + 1);
+                    key.erase(equals);
+                }
+                else if (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0)
+                {
+                    value = argv[++i];
+                }
+                if (key != "config")
+                    set(key, value);
+            }
+            return true;
+        }
+
+        bool load_file(const std::string &path, std::string *error = nullptr)
+        {
+            std::FILE *file = std::fopen(path.c_str(), "rb");
+            if (!file)
+            {
+                if (error)
+                    *error = "cannot open config file " + path;
+                return false;
+            }
+            std::string text;
+            std::fseek(file, 0, SEEK_END);
+            long size = std::ftell(file);
+            std::fseek(file, 0, SEEK_SET);
+            if (size > 0)
+            {
+                text.resize(static_cast<size_t>(size));
+                text.resize(std::fread(&text[0], 1, text.size(), file));
+            }
+            std::fclose(file);
+            parse(text.data(), text.size());
+            return true;
+        }
+
+        // Parses "key = value" lines; malformed lines are ignored
+        void parse(const char *data, size_t size)
+        {
+            const char *end = data + size;
+            while (data < end)
+            {
+                const char *line_end = static_cast<const char *>(std::memchr(data, '\n', end - data));
+                if (!line_end)
+                    line_end = end;
+                const char *comment = static_cast<const char *>(std::memchr(data, '#', line_end - data));
+                const char *equals = static_cast<const char *>(std::memchr(data, '=', (comment ? comment : line_end) - data));
+                if (equals)
+                {
+                    std::string key = trim(data, equals);
+                    if (!key.empty())
+                        set(key, trim(equals + 1, comment ? comment : line_end));
+                }
+                data = line_end + 1;
+            }
+        }
+
+        void set(std::string key, const std::string &value) { values_[normalise(std::move(key))] = value; }
+
+        bool has(const std::string &key) const { return values_.count(normalise(key)) > 0; }
+
+        std::string get(const std::string &key, const std::string &fallback = std::string()) const
+        {
+            auto it = values_.find(normalise(key));
+            return it == values_.end() ? fallback : it->second;
+        }
+
+        long get_int(const std::string &key, long fallback) const
+        {
+            auto it = values_.find(normalise(key));
+            if (it == values_.end())
+                return fallback;
+            char *end = nullptr;
+            long value = std::strtol(it->second.c_str(), &end, 10);
+            return end == it->second.c_str() ? fallback : value;
+        }
+
+        double get_double(const std::string &key, double fallback) const
+        {
+            auto it = values_.find(normalise(key));
+            if (it == values_.end())
+                return fallback;
+            char *end = nullptr;
+            double value = std::strtod(it->second.c_str(), &end);
+            return end == it->second.c_str() ? fallback : value;
+        }
+
+        bool get_bool(const std::string &key, bool fallback) const
+        {
+            auto it = values_.find(normalise(key));
+            if (it == values_.end())
+                return fallback;
+            const std::string &value = it->second;
+            return value == "true" || value == "1" || value == "yes" || value == "on";
+        }
+
+        // Every key starting with prefix (already normalised), e.g. "drone." for static drones
+        std::vector<std::pair<std::string, std::string>> with_prefix(const std::string &prefix) const
+        {
+            std::vector<std::pair<std::string, std::string>> matches;
+            std::string wanted = normalise(prefix);
+            for (const auto &entry : values_)
+            {
+                if (entry.first.compare(0, wanted.size(), wanted) == 0)
+                    matches.push_back(entry);
+            }
+            return matches;
+        }
+
+    private:
+        static std::string normalise(std::string key)
+        {
+            for (char &c : key)
+            {
+                if (c == '-')
+                    c = '_';
+            }
+            return key;
+        }
+
+        static std::string trim(const char *begin, const char *end)
+        {
+            while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r'))
+                ++begin;
+            while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+                --end;
+            return std::string(begin, end);
+        }
+
+        std::unordered_map<std::string, std::string> values_;
+    };
+}
@@ -3,70 +3,82 @@
 #include <thread>
 #include <string>
 #include <atomic>
-#include <fstream>
 #include <vector>
+#include <algorithm>
 #include <chrono>
+#include <mutex>
+#include "cc_channel.hpp"
+#include "cc_config.hpp"
+#include "cc_filesource.hpp"
+#include "cc_commands.hpp"
+#include "cc_lowlatency.hpp"
+#include "cc_trace.hpp"
+#include "cc_backoff.hpp"
+#include <cstring>
+#include <cstdlib>
 
 using boost::asio::ip::tcp;
 using boost::asio::ip::udp;
 
-// XOR Encryption/Decryption Function
-std::string xor_cipher(const std::string &data, char key)
-{
-    std::string result = data;
-    for (auto &c : result)
-        c ^= key;
-    return result;
-}
+// Wire configuration. This drone pairs with cc_server, which XOR-encrypts telemetry and commands.
+typedef cc::XorCipher<0x42> LinkCipher;
+typedef cc::Channel<cc::UdpDatagram, cc::DatagramFraming, LinkCipher, cc::CommandCodec> CommandChannel;
+typedef cc::Channel<cc::TcpStream, cc::LineFraming, LinkCipher, cc::StringCodec> TelemetryChannel;
+typedef cc::Channel<cc::TcpStream, cc::RawFraming, cc::NoCipher, cc::StringCodec> FileChannel;
 
-// Drone's position coordinates
-int x = 0, y = 0;
+// Drone's position, altitude and speed
+cc::DroneState state;
+std::vector<cc::DroneHop> pending_traces; // Commands applied since the last telemetry (guarded by state_mutex)
+std::mutex state_mutex;
 
 // Atomic flag to signal connection status
 std::atomic<bool> is_connected(false);
 
 // Function to receive and process control commands from the server
-void receive_control_commands(boost::asio::io_context &io_context, unsigned short port, char key)
+void receive_control_commands(boost::asio::io_context &io_context, unsigned short port, cc::ControlLatencyOptions latency)
 {
-    udp::socket socket(io_context, udp::endpoint(udp::v4(), port));
+    CommandChannel control(cc::UdpDatagram(udp::socket(io_context, udp::endpoint(udp::v4(), port)), udp::endpoint(), latency));
+    cc::configure_control_socket(control.transport().socket(), latency);
     std::cout << "Control Command Receiver started on port " << port << std::endl;
 
-    udp::endpoint sender_endpoint;
-
     while (true) // Infinite loop to continuously receive commands
     {
         try
         {
-            std::vector<char> data(1024);
             boost::system::error_code error;
 
             // Receive the command from the server
-            size_t length = socket.receive_from(boost::asio::buffer(data), sender_endpoint, 0, error);
+            cc::Frame frame;
+            bool received = control.receive_frame(frame, error);
+            uint64_t received_ns = cc::monotonic_ns();
 
-            if (error && error != boost::asio::error::message_size)
+            if (!received)
             {
                 std::cerr << "Error receiving control command: " << error.message() << std::endl;
                 continue;
             }
 
-            // Create a std::string from the received data
-            std::string encrypted_command(data.data(), length);
-
-            encrypted_command.erase(std::remove(encrypted_command.begin(), encrypted_command.end(), '\n'), encrypted_command.end());
-            std::string command = xor_cipher(encrypted_command, key);
+            // Decrypt the datagram and decode the binary command
+            cc::Command command;
+            std::string decode_error;
+            if (!CommandChannel::open(frame, command, &decode_error))
+            {
+                std::cerr << "Rejected control command: " << decode_error << std::endl;
+                continue;
+            }
 
-            // Update drone position based on the command
-            if (command == "move front")
-                y += 1;
-            else if (command == "move back")
-                y -= 1;
-            else if (command == "move left")
-                x -= 1;
-            else if (command == "move right")
-                x += 1;
+            // Update drone state based on the command
+            double x, y;
+            {
+                std::lock_guard<std::mutex> lock(state_mutex);
+                cc::apply_command(state, command);
+                pending_traces.push_back(cc::DroneHop{command.id, received_ns, cc::monotonic_ns()});
+                x = state.x;
+                y = state.y;
+            }
 
             // Display updated position
-            std::cout << "Received command: " << command << ". Updated position: (" << x << ", " << y << ")" << std::endl;
+            std::cout << "Received command: " << cc::format_command(command) << ". Updated position: (" << x << ", " << y << ")" << std::endl;
         }
         catch (const std::exception &e)
         {
@@ -76,13 +88,17 @@ void receive_control_commands(boost::asio::io_context &io_context, unsigned shor
 }
 
 // Function to send telemetry data to the server
-void send_telemetry_data(boost::asio::io_context &io_context, const std::string &server_ip, unsigned short port, char key)
+void send_telemetry_data(boost::asio::io_context &io_context, const std::string &server_ip, unsigned short port, std::chrono::milliseconds interval)
 {
     try
     {
-        tcp::socket socket(io_context);
+        TelemetryChannel telemetry(io_context);
+        tcp::socket &socket = telemetry.transport().socket();
         tcp::endpoint server_endpoint(boost::asio::ip::make_address(server_ip), port);
 
+        // Jittered so a fleet that lost the server together does not reconnect in lockstep
+        cc::DecorrelatedJitter backoff(std::chrono::milliseconds(500), std::chrono::seconds(30));
+
         // Attempt to connect to the server
         socket.connect(server_endpoint);
         is_connected.store(true); // Set connection status
@@ -91,34 +107,54 @@ void send_telemetry_data(boost::asio::io_context &io_context, const std::string
         while (true) // Infinite loop to continuously send telemetry data
         {
             // Create a string representation of the current drone position
-            std::string position = "Position: (" + std::to_string(x) + ", " + std::to_string(y) + ")";
-            std::string encrypted_data = xor_cipher(position, key) + "\n"; // Encrypt and add newline character
+            double x, y, altitude;
+            std::vector<cc::DroneHop> traces;
+            {
+                std::lock_guard<std::mutex> lock(state_mutex);
+                x = state.x;
+                y = state.y;
+                altitude = state.altitude;
+                traces.swap(pending_traces);
+            }
+            std::string position = "Position: (" + std::to_string(x) + ", " + std::to_string(y) + ") Altitude: " + std::to_string(altitude) +
+                                   cc::format_trace_suffix(traces, cc::monotonic_ns()); // Echo command ids for latency tracing
 
+            // Encrypted and newline-terminated by the channel
             boost::system::error_code error;
-            size_t bytes_sent = boost::asio::write(socket, boost::asio::buffer(encrypted_data), error);
+            size_t bytes_sent = telemetry.send(position, error);
 
             if (error)
             {
                 std::cerr << "Error sending data: " << error.message() << std::endl;
 
+                // Echo these command ids again in the next line that gets through
+                {
+                    std::lock_guard<std::mutex> lock(state_mutex);
+                    pending_traces.insert(pending_traces.begin(), traces.begin(), traces.end());
+                }
+
                 // Handle connection errors
                 if (error == boost::asio::error::eof ||
                     error == boost::asio::error::connection_reset ||
-                    error == boost::asio::error::connection_aborted)
+                    error == boost::asio::error::connection_aborted ||
+                    error == boost::asio::error::broken_pipe)
                 {
                     std::cerr << "Connection issues detected. Attempting to reconnect..." << std::endl;
 
                     socket.close();
                     is_connected.store(false); // Update connection status
 
-                    // Attempt reconnection
-                    std::this_thread::sleep_for(std::chrono::seconds(10)); // Wait before retrying
-                    socket.connect(server_endpoint, error);
-                    if (!error)
+                    // Attempt reconnection until it succeeds
+                    do
                     {
-                        std::cout << "Reconnected successfully." << std::endl;
-                        is_connected.store(true); // Restore connection status
-                    }
+                        std::this_thread::sleep_for(backoff.next()); // Wait before retrying
+                        socket.close();
+                        socket.connect(server_endpoint, error);
+                    } while (error);
+
+                    backoff.reset();
+                    std::cout << "Reconnected successfully." << std::endl;
+                    is_connected.store(true); // Restore connection status
                 }
                 continue;
             }
@@ -126,7 +162,7 @@ void send_telemetry_data(boost::asio::io_context &io_context, const std::string
             std::cout << "Sent telemetry data: " << position << " (" << bytes_sent << " bytes)." << std::endl;
 
             // Delay between telemetry updates (adjust as needed)
-            std::this_thread::sleep_for(std::chrono::seconds(60)); // Sends position every 1 minute
+            std::this_thread::sleep_for(interval);
         }
     }
     catch (const std::exception &e)
@@ -136,38 +172,41 @@ void send_telemetry_data(boost::asio::io_context &io_context, const std::string
 }
 
 // Function to send a large file periodically using TCP
-void send_large_file_tcp(const std::string &file_path, const std::string &server_ip, unsigned short port)
+void send_large_file_tcp(const std::string &file_path, const std::string &server_ip, unsigned short port, size_t chunk_size,
+                         cc::FileSourceOptions file_source, std::chrono::milliseconds interval)
 {
     while (true) // Infinite loop to periodically send the file
     {
-        // Wait for 5 minutes after connection is established
-        std::this_thread::sleep_for(std::chrono::minutes(5));
+        // Wait after connection is established
+        std::this_thread::sleep_for(interval);
 
         if (is_connected.load()) // Only send the file if connected
         {
             try
             {
                 boost::asio::io_context io_context;
-                tcp::socket socket(io_context);
+                FileChannel channel(io_context);
+                tcp::socket &socket = channel.transport().socket();
                 tcp::endpoint server_endpoint(boost::asio::ip::make_address(server_ip), port);
 
                 socket.connect(server_endpoint);
                 std::cout << "Connected to server for file transfer." << std::endl;
 
-                std::ifstream file(file_path, std::ios::binary);
-                if (!file)
+                // Large sequential reads (mapped or double-buffered) with drop-behind, see cc_filesource.hpp
+                cc::FileSource file;
+                std::string open_error;
+                if (!file.open(file_path, file_source, &open_error))
                 {
-                    std::cerr << "Error opening file: " << file_path << std::endl;
+                    std::cerr << "Error opening file: " << open_error << std::endl;
                     return;
                 }
 
-                std::vector<char> buffer(1024); // Buffer for reading file chunks
-
-                while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0)
+                const char *chunk;
+                size_t length;
+                while (file.next(chunk, length, chunk_size))
                 {
-                    size_t bytes_read = file.gcount();
                     boost::system::error_code error;
-                    size_t bytes_sent = boost::asio::write(socket, boost::asio::buffer(buffer.data(), bytes_read), error);
+                    size_t bytes_sent = channel.send(chunk, length, error);
 
                     if (error)
                     {
@@ -178,7 +217,9 @@ void send_large_file_tcp(const std::string &file_path, const std::string &server
                     std::cout << "Sent chunk of " << bytes_sent << " bytes." << std::endl;
                 }
 
-                std::cout << "File transfer completed." << std::endl;
+                if (file.failed())
+                    std::cerr << "Error reading file: " << file_path << std::endl;
+                std::cout << "File transfer completed (" << file.mode_name() << ")." << std::endl;
 
                 // Clean up: Shutdown and close the socket gracefully
                 boost::system::error_code shutdown_error;
@@ -203,27 +244,49 @@ void send_large_file_tcp(const std::string &file_path, const std::string &server
             }
         }
 
-        // Wait for 5 minutes before the next file transfer
-        std::this_thread::sleep_for(std::chrono::minutes(5));
+        // Wait before the next file transfer
+        std::this_thread::sleep_for(interval);
     }
 }
 
-int main()
+// Settings come from --config <file> and the command line (see cc_config.hpp):
+//   server, control_port, telemetry_port, file_port, file_path, chunk_size,
+//   file_source (auto|mmap|buffered), file_block, drop_behind,
+//   telemetry_interval, file_interval (seconds), low_latency, control_core
+int main(int argc, char *argv[])
 {
-    char key = 0x42; // XOR cipher key
-    unsigned short control_port = 9000;
-    unsigned short telemetry_port = 9001;
-    unsigned short file_transfer_port = 9002; // Port for file transfer
+    cc::Config config;
+    std::string config_error;
+    if (!config.load(argc, argv, &config_error))
+    {
+        std::cerr << config_error << std::endl;
+        return 1;
+    }
+
+    cc::ControlLatencyOptions latency;
+    latency.busy_poll = config.get_bool("low_latency", false);
+    latency.core = static_cast<int>(config.get_int("control_core", -1));
+
+    unsigned short control_port = static_cast<unsigned short>(config.get_int("control_port", 9000));
+    unsigned short telemetry_port = static_cast<unsigned short>(config.get_int("telemetry_port", 9001));
+    unsigned short file_transfer_port = static_cast<unsigned short>(config.get_int("file_port", 9002)); // Port for file transfer
+    std::chrono::milliseconds telemetry_interval(static_cast<long long>(config.get_double("telemetry_interval", 60.0) * 1000.0)); // Position every minute
+    std::chrono::milliseconds file_interval(static_cast<long long>(config.get_double("file_interval", 300.0) * 1000.0));
+    size_t chunk_size = static_cast<size_t>(std::max(1L, config.get_int("chunk_size", 64 * 1024)));
+    cc::FileSourceOptions file_source;
+    if (config.has("file_source") && !cc::parse_file_source_mode(config.get("file_source"), file_source.mode))
+        std::cerr << "Unknown file_source (use auto, mmap or buffered): " << config.get("file_source") << std::endl;
+    file_source.block_size = static_cast<size_t>(std::max(4096L, config.get_int("file_block", static_cast<long>(file_source.block_size))));
+    file_source.drop_behind = config.get_bool("drop_behind", true);
 
     boost::asio::io_context io_context;
 
-    // Replace with the path to the large file you want to send
-    std::string file_path = "./big_file.txt";
-    std::string server_ip = "127.0.0.1"; // Replace with the actual server IP address
+    std::string file_path = config.get("file_path", "./big_file.txt");
+    std::string server_ip = config.get("server", "127.0.0.1");
 
-    std::thread control_thread(receive_control_commands, std::ref(io_context), control_port, key);
-    std::thread telemetry_thread(send_telemetry_data, std::ref(io_context), server_ip, telemetry_port, key);
-    std::thread file_transfer_thread(send_large_file_tcp, file_path, server_ip, file_transfer_port);
+    std::thread control_thread(receive_control_commands, std::ref(io_context), control_port, latency);
+    std::thread telemetry_thread(send_telemetry_data, std::ref(io_context), server_ip, telemetry_port, telemetry_interval);
+    std::thread file_transfer_thread(send_large_file_tcp, file_path, server_ip, file_transfer_port, chunk_size, file_source, file_interval);
 
     control_thread.join();
     telemetry_thread.join();
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <string>
+#include <vector>
+
+// Sequential file source for file transfers on the drone.
+//
+// Reading through an ifstream in 1 KiB steps issues a small read per chunk and leaves
+// every page in the page cache. A FileSource instead hands out spans of the file
+// directly, in one of two modes:
+//
+//   Mapped    the file is mmap'ed; spans point into the mapping. The kernel is told
+//             the access is sequential, the next block is prefetched (MADV_WILLNEED)
+//             as the sender enters the current one, and blocks already sent are
+//             dropped from the mapping and the page cache.
+//   Buffered  two large buffers: while the sender drains one, the next block is read
+//             into the other by a background pread. Blocks already sent are dropped
+//             from the page cache (POSIX_FADV_DONTNEED).
+//
+// Auto picks Mapped and falls back to Buffered when the file cannot be mapped.
+// Drop-behind keeps a RAM-constrained drone from filling memory with a file it will
+// not read again; turn it off if the file is sent repeatedly and fits in memory.
+namespace cc
+{
+    enum class FileSourceMode
+    {
+        Auto,
+        Mapped,
+        Buffered
+    };
+
+    inline bool parse_file_source_mode(const std::string &text, FileSourceMode &mode)
+    {
+        if (text == "auto")
+            mode = FileSourceMode::Auto;
+        else if (text == "mmap")
+            mode = FileSourceMode::Mapped;
+        else if (text == "buffered")
+            mode = FileSourceMode::Buffered;
+        else
+            return false;
+        return true;
+    }
+
+    struct FileSourceOptions
+    {
+        FileSourceMode mode = FileSourceMode::Auto;
+        size_t block_size = 1 << 20; // Read-ahead and drop-behind granularity
+        bool drop_behind = true;
+    };
+
+    class FileSource
+    {
+    public:
+        FileSource() = default;
+        FileSource(const FileSource &) = delete;
+        FileSource &operator=(const FileSource &) = delete;
+        ~FileSource() { close(); }
+
+        bool open(const std::string &path, const FileSourceOptions &options = FileSourceOptions(), std::string *error = nullptr)
+        {
+            close();
+            options_ = options;
+            long page = ::sysconf(_SC_PAGESIZE);
+            size_t page_size = page > 0 ? static_cast<size_t>(page) : 4096;
+            options_.block_size = std::max(page_size, options_.block_size / page_size * page_size);
+
+            fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat info;
+            if (fd_ < 0 || ::fstat(fd_, &info) != 0)
+            {
+                if (error)
+                    *error = path + ": " + std::strerror(errno);
+                close();
+                return false;
+            }
+            size_ = static_cast<uint64_t>(info.st_size);
+            ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+            if (options_.mode != FileSourceMode::Buffered && size_ > 0)
+            {
+                void *mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+                if (mapping != MAP_FAILED)
+                {
+                    mapping_ = static_cast<char *>(mapping);
+                    mode_ = FileSourceMode::Mapped;
+                    ::madvise(mapping_, size_, MADV_SEQUENTIAL);
+                    prefetch(0);
+                    return true;
+                }
+                if (options_.mode == FileSourceMode::Mapped)
+                {
+                    if (error)
+                        *error = path + ": mmap: " + std::strerror(errno);
+                    close();
+                    return false;
+                }
+            }
+
+            mode_ = FileSourceMode::Buffered;
+            for (auto &buffer : buffers_)
+                buffer.resize(options_.block_size);
+            start_read(0, 0);
+            return true;
+        }
+
+        // The next span of at most max bytes, valid until the following call.
+        // Returns false at end of file or on a read error (see failed()).
+        bool next(const char *&data, size_t &size, size_t max)
+        {
+            if (mode_ == FileSourceMode::Mapped)
+                return next_mapped(data, size, max);
+            return next_buffered(data, size, max);
+        }
+
+        void close()
+        {
+            if (pending_.valid())
+                pending_.wait();
+            if (mapping_)
+                ::munmap(mapping_, size_);
+            if (fd_ >= 0)
+                ::close(fd_);
+            mapping_ = nullptr;
+            fd_ = -1;
+            size_ = offset_ = block_start_ = block_end_ = dropped_ = 0;
+            current_ = pending_index_ = 0;
+            failed_ = false;
+        }
+
+        uint64_t size() const { return size_; }
+        bool failed() const { return failed_; }
+        const char *mode_name() const { return mode_ == FileSourceMode::Mapped ? "mmap" : "buffered"; }
+
+    private:
+        bool next_mapped(const char *&data, size_t &size, size_t max)
+        {
+            if (offset_ >= size_)
+            {
+                drop_behind(size_);
+                return false;
+            }
+            // Entering a new block: prefetch the one after it and drop the ones already sent
+            if (offset_ >= block_end_)
+            {
+                block_start_ = offset_ / options_.block_size * options_.block_size;
+                block_end_ = block_start_ + options_.block_size;
+                prefetch(block_end_);
+                drop_behind(block_start_);
+            }
+            size = static_cast<size_t>(std::min<uint64_t>(max, size_ - offset_));
+            data = mapping_ + offset_;
+            offset_ += size;
+            return true;
+        }
+
+        bool next_buffered(const char *&data, size_t &size, size_t max)
+        {
+            if (offset_ >= block_end_)
+            {
+                if (!pending_.valid())
+                {
+                    drop_behind(offset_);
+                    return false;
+                }
+                ssize_t length = pending_.get();
+                if (length < 0)
+                {
+                    failed_ = true;
+                    return false;
+                }
+                if (length == 0)
+                {
+                    drop_behind(size_);
+                    return false;
+                }
+                drop_behind(offset_);
+
+                // The block just read becomes current; the other buffer starts on the next one
+                current_ = pending_index_;
+                block_start_ = offset_;
+                block_end_ = offset_ + static_cast<uint64_t>(length);
+                if (block_end_ < size_)
+                    start_read(1 - current_, block_end_);
+            }
+            size = static_cast<size_t>(std::min<uint64_t>(max, block_end_ - offset_));
+            data = buffers_[current_].data() + (offset_ - block_start_);
+            offset_ += size;
+            return true;
+        }
+
+        // Reads one block at offset into buffers_[index] in the background
+        void start_read(int index, uint64_t offset)
+        {
+            int fd = fd_;
+            pending_index_ = index;
+            char *buffer = buffers_[index].data();
+            size_t capacity = buffers_[index].size();
+            pending_ = std::async(std::launch::async, [fd, buffer, capacity, offset]()
+                                  {
+                                      size_t filled = 0;
+                                      while (filled < capacity)
+                                      {
+                                          ssize_t length = ::pread(fd, buffer + filled, capacity - filled, static_cast<off_t>(offset + filled));
+                                          if (length < 0 && errno == EINTR)
+                                              continue;
+                                          if (length < 0)
+                                              return length;
+                                          if (length == 0)
+                                              break;
+                                          filled += static_cast<size_t>(length);
+                                      }
+                                      return static_cast<ssize_t>(filled); });
+        }
+
+        void prefetch(uint64_t offset)
+        {
+            if (offset < size_)
+                ::madvise(mapping_ + offset, static_cast<size_t>(std::min<uint64_t>(options_.block_size, size_ - offset)), MADV_WILLNEED);
+        }
+
+        // Releases [dropped_, end) from the mapping and the page cache. Pages still under
+        // kernel readahead I/O cannot be dropped yet, so the final call at end of file
+        // sweeps the whole file once more.
+        void drop_behind(uint64_t end)
+        {
+            if (!options_.drop_behind || end <= dropped_)
+                return;
+            uint64_t start = end >= size_ ? 0 : dropped_;
+            if (mapping_)
+                ::madvise(mapping_ + start, static_cast<size_t>(end - start), MADV_DONTNEED);
+            ::posix_fadvise(fd_, static_cast<off_t>(start), static_cast<off_t>(end - start), POSIX_FADV_DONTNEED);
+            dropped_ = end;
+        }
+
+        FileSourceOptions options_;
+        FileSourceMode mode_ = FileSourceMode::Buffered;
+        int fd_ = -1;
+        uint64_t size_ = 0;
+        uint64_t offset_ = 0;  // Next byte handed out
+        uint64_t dropped_ = 0; // Everything before this has been released
+
+        char *mapping_ = nullptr;
+
+        std::vector<char> buffers_[2];
+        int current_ = 0;
+        int pending_index_ = 0;
+        uint64_t block_start_ = 0; // Current block: held by buffers_[current_] or, mapped, the block being sent
+        uint64_t block_end_ = 0;
+        std::future<ssize_t> pending_;
+        bool failed_ = false;
+    };
+}
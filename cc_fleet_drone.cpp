@@ -0,0 +1,508 @@
+#include <iostream>
+#include <boost/asio.hpp>
+#include <thread>
+#include <string>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "cc_channel.hpp"
+#include "cc_commands.hpp"
+#include "cc_lowlatency.hpp"
+#include "cc_trace.hpp"
+#include "cc_backoff.hpp"
+#include "cc_config.hpp"
+#include "cc_filesource.hpp"
+#include "cc_registration.hpp"
+#include "cc_upload.hpp"
+#include <cstring>
+#include <cstdlib>
+
+using boost::asio::ip::tcp;
+using boost::asio::ip::udp;
+
+// One binary for every drone in the fleet. Identity, ports, rates and sizes come from
+// the config file and command line (see load_settings); with registration on, the
+// server assigns the id and ports at startup.
+struct DroneSettings
+{
+    int drone_id = 0; // 0: assigned by the server
+    std::string server_ip = "127.0.0.1";
+    bool register_with_server = true;
+    unsigned short registration_port = 8999;
+    unsigned short control_port = 0; // 0: assigned by the server
+    unsigned short telemetry_port = 9001;
+    unsigned short file_port = 9003;
+    std::chrono::milliseconds telemetry_interval{180000}; // Send every 3 minutes
+    std::chrono::milliseconds file_delay{60000};          // Before each file transfer
+    std::chrono::milliseconds file_interval{300000};      // After each file transfer
+    std::string file_path = "./big_file.txt";
+    size_t chunk_size = 64 * 1024; // Bytes per file-transfer write
+    cc::FileSourceOptions file_source;
+    cc::UploadPriority file_priority = cc::UploadPriority::Normal; // Place in the server's upload queue
+    size_t control_buffer = 4096; // Largest command datagram
+    bool datagram_telemetry = false; // TCP unless telemetry = udp
+    int udp_fallback_after = 3;      // Unacknowledged datagrams before falling back to TCP
+    cc::ControlLatencyOptions latency;
+};
+
+std::atomic<bool> is_connected(false);
+cc::DroneState state; // Initial position (0, 0)
+std::vector<cc::DroneHop> pending_traces; // Commands applied since the last telemetry (guarded by state_mutex)
+const uint32_t telemetry_session = std::random_device{}() | 1; // New each run, so the server can tell a restart from a late sample
+std::mutex state_mutex;
+
+// Wire configuration. The multi-drone server speaks plaintext on every channel.
+typedef cc::Channel<cc::UdpDatagram, cc::DatagramFraming, cc::NoCipher, cc::CommandCodec> CommandChannel;
+typedef cc::Channel<cc::TcpStream, cc::LineFraming, cc::NoCipher, cc::StringCodec> TelemetryChannel;
+typedef cc::Channel<cc::UdpDatagram, cc::DatagramFraming, cc::NoCipher, cc::StringCodec> DatagramTelemetryChannel;
+typedef cc::Channel<cc::TcpStream, cc::RawFraming, cc::NoCipher, cc::StringCodec> FileChannel;
+
+void update_position(const cc::Command &command, uint64_t received_ns)
+{
+    std::lock_guard<std::mutex> lock(state_mutex);
+
+    // Dispatch through the command schema's jump table
+    cc::apply_command(state, command);
+    pending_traces.push_back(cc::DroneHop{command.id, received_ns, cc::monotonic_ns()});
+
+    std::cout << "Drone moved to position (" << state.x << ", " << state.y << ") altitude " << state.altitude
+              << (state.hovering ? " [hovering]" : "") << std::endl;
+}
+
+void receive_control_commands(boost::asio::io_context &io_context, const DroneSettings &settings)
+{
+    int drone_id = settings.drone_id;
+    unsigned short port = settings.control_port;
+    CommandChannel control(cc::UdpDatagram(udp::socket(io_context, udp::endpoint(udp::v4(), port)), udp::endpoint(), settings.latency), settings.control_buffer);
+    control.transport().socket().set_option(boost::asio::socket_base::reuse_address(true));
+    cc::configure_control_socket(control.transport().socket(), settings.latency);
+    std::cout << "Drone " << drone_id << " Control Command Receiver started on port " << port << std::endl;
+
+    while (true)
+    {
+        try
+        {
+            boost::system::error_code error;
+            cc::Frame frame;
+            bool received = control.receive_frame(frame, error);
+            uint64_t received_ns = cc::monotonic_ns();
+            if (!received)
+            {
+                std::cerr << "Drone " << drone_id << " Error receiving command: " << error.message() << std::endl;
+                continue;
+            }
+
+            cc::Command command;
+            std::string decode_error;
+            if (!CommandChannel::open(frame, command, &decode_error))
+            {
+                std::cerr << "Drone " << drone_id << " Rejected command: " << decode_error << std::endl;
+                continue;
+            }
+            std::cout << "Drone " << drone_id << " Received command: " << cc::format_command(command) << std::endl;
+            update_position(command, received_ns); // Update position based on the command
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error receiving command: " << e.what() << std::endl;
+        }
+    }
+}
+
+// Samples are numbered on both transports so the server can spot gaps, reordering and duplicates
+// traces receives the hops echoed in the line, for restore_traces if the send fails.
+std::string next_telemetry_line(int drone_id, uint64_t seq, std::vector<cc::DroneHop> &traces)
+{
+    double x, y, altitude;
+    traces.clear();
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        x = state.x;
+        y = state.y;
+        altitude = state.altitude;
+        traces.swap(pending_traces);
+    }
+    return "Telemetry data from Drone " + std::to_string(drone_id) + " - Session: " + std::to_string(telemetry_session) +
+           " - Seq: " + std::to_string(seq) +
+           " - Position: (" + std::to_string(x) + ", " + std::to_string(y) + ")" +
+           " - Altitude: " + std::to_string(altitude) +
+           cc::format_trace_suffix(traces, cc::monotonic_ns()); // Echo command ids for latency tracing
+}
+
+// Puts back the hops of a line that was not sent, ahead of any applied since
+void restore_traces(const std::vector<cc::DroneHop> &traces)
+{
+    if (traces.empty())
+        return;
+    std::lock_guard<std::mutex> lock(state_mutex);
+    pending_traces.insert(pending_traces.begin(), traces.begin(), traces.end());
+}
+
+// Registers (or re-registers) with the server, retrying with jittered backoff until it
+// answers. Asks for the id and control port already held, so they survive a server restart.
+cc::Registration register_drone(boost::asio::io_context &io_context, const DroneSettings &settings)
+{
+    cc::DecorrelatedJitter backoff(std::chrono::milliseconds(500), std::chrono::seconds(30), std::random_device{}() ^ settings.drone_id);
+    while (true)
+    {
+        cc::Registration registration;
+        std::string error;
+        if (cc::register_drone(io_context, settings.server_ip, settings.registration_port, settings.drone_id, settings.control_port, registration, &error))
+        {
+            std::cout << "Registered as drone " << registration.drone_id << ": control port " << registration.control_port << ", telemetry port "
+                      << registration.telemetry_port << ", file port " << registration.file_port << std::endl;
+            return registration;
+        }
+        std::chrono::milliseconds delay = backoff.next();
+        std::cerr << "Registration failed (" << error << "), retrying in " << delay.count() << " ms" << std::endl;
+        std::this_thread::sleep_for(delay);
+    }
+}
+
+// The server acknowledges each sender at most once a second, so shorter silences mean nothing
+const std::chrono::milliseconds datagram_ack_silence(2500);
+
+// Why send_datagram_telemetry gave up
+enum class DatagramEnd
+{
+    Unacknowledged, // No reply at all: the network is taken to drop UDP
+    Lost,           // Replies stopped for udp_fallback_after samples, e.g. the server restarted
+    Rejected        // The server answered NACK: it does not know this drone
+};
+
+// Sends one datagram per sample, so a lost packet costs that sample and nothing behind it.
+// The server acknowledges datagrams from registered drones and NACKs the rest. This returns
+// after udp_fallback_after samples in a row (and datagram_ack_silence) go unacknowledged, or on a NACK when the drone
+// registers with the server; the caller decides whether to register again or use TCP.
+DatagramEnd send_datagram_telemetry(boost::asio::io_context &io_context, const DroneSettings &settings, unsigned short port, uint64_t &seq)
+{
+    int drone_id = settings.drone_id;
+    const std::string &server_ip = settings.server_ip;
+    int fallback_after = settings.udp_fallback_after;
+    udp::endpoint server_endpoint(boost::asio::ip::make_address(server_ip), port);
+    DatagramTelemetryChannel telemetry(cc::UdpDatagram(udp::socket(io_context, udp::v4()), server_endpoint));
+    udp::socket &socket = telemetry.transport().socket();
+    socket.non_blocking(true);
+    std::cout << "Drone " << drone_id << " sending datagram telemetry to IP: " << server_ip << ", Port: " << port << std::endl;
+
+    int unacknowledged = 0;
+    bool sent = false;
+    bool heard = false; // Any acknowledgement since this call started
+    auto last_ack = std::chrono::steady_clock::now();
+    while (unacknowledged < fallback_after || std::chrono::steady_clock::now() - last_ack < datagram_ack_silence)
+    {
+        // Any acknowledgement since the last sample shows datagrams are getting through
+        bool acknowledged = false;
+        bool rejected = false;
+        char ack[16];
+        udp::endpoint sender;
+        boost::system::error_code error;
+        while (!error)
+        {
+            size_t length = socket.receive_from(boost::asio::buffer(ack), sender, 0, error);
+            acknowledged = acknowledged || !error;
+            rejected = rejected || (!error && std::string(ack, length) == "NACK");
+        }
+        if (rejected && settings.register_with_server)
+        {
+            is_connected.store(false);
+            std::cerr << "Drone " << drone_id << " Server does not know this drone, registering again" << std::endl;
+            return DatagramEnd::Rejected;
+        }
+        if (acknowledged)
+        {
+            heard = true;
+            unacknowledged = 0;
+            last_ack = std::chrono::steady_clock::now();
+            is_connected.store(true);
+        }
+        else if (sent)
+        {
+            unacknowledged++;
+        }
+
+        std::vector<cc::DroneHop> traces;
+        std::string data = next_telemetry_line(drone_id, ++seq, traces);
+        error.clear();
+        telemetry.send(data, error);
+        if (error)
+        {
+            restore_traces(traces);
+            std::cerr << "Drone " << drone_id << " Error sending telemetry datagram: " << error.message() << std::endl;
+        }
+        else
+            std::cout << "Drone " << drone_id << " Sent telemetry datagram: " << data << std::endl;
+        sent = true;
+        std::this_thread::sleep_for(settings.telemetry_interval);
+    }
+
+    is_connected.store(false);
+    std::cerr << "Drone " << drone_id << " No acknowledgement for " << fallback_after << " telemetry datagrams" << std::endl;
+    return heard ? DatagramEnd::Lost : DatagramEnd::Unacknowledged;
+}
+
+// The server closed or reset the link, as it does when it restarts
+bool connection_reset(const boost::system::error_code &error)
+{
+    return error == boost::asio::error::eof ||
+           error == boost::asio::error::connection_reset ||
+           error == boost::asio::error::connection_aborted ||
+           error == boost::asio::error::broken_pipe;
+}
+
+void send_telemetry_data(boost::asio::io_context &io_context, const DroneSettings &settings)
+{
+    int drone_id = settings.drone_id;
+    unsigned short telemetry_port = settings.telemetry_port; // Refreshed by re-registration
+    bool reregister = false;
+    uint64_t seq = 0;
+
+    // Jittered so a fleet that lost the server together does not reconnect in lockstep
+    cc::DecorrelatedJitter backoff(std::chrono::milliseconds(500), std::chrono::seconds(30), std::random_device{}() ^ drone_id);
+    while (true)
+    {
+        if (settings.datagram_telemetry)
+        {
+            DatagramEnd end = send_datagram_telemetry(io_context, settings, telemetry_port, seq);
+            // A NACK means the server has forgotten this drone, and acknowledgements that stop
+            // may mean it restarted. Registering covers both and waits out a server that is down.
+            if (settings.register_with_server)
+                telemetry_port = register_drone(io_context, settings).telemetry_port;
+            // Only a server that never acknowledged anything means UDP does not get through
+            if (end != DatagramEnd::Unacknowledged)
+                continue;
+            std::cerr << "Drone " << drone_id << " falling back to TCP" << std::endl;
+        }
+
+        try
+        {
+            TelemetryChannel telemetry(io_context);
+            tcp::socket &socket = telemetry.transport().socket();
+            tcp::endpoint server_endpoint(boost::asio::ip::make_address(settings.server_ip), telemetry_port);
+            std::cout << "Drone " << drone_id << " attempting to connect to IP: " << settings.server_ip << ", Port: " << telemetry_port << std::endl;
+            socket.connect(server_endpoint);
+            is_connected.store(true);
+            backoff.reset();
+            std::cout << "Drone " << drone_id << " Connected to server for telemetry data." << std::endl;
+
+            while (is_connected.load())
+            {
+                std::vector<cc::DroneHop> traces;
+                std::string data = next_telemetry_line(drone_id, ++seq, traces);
+                boost::system::error_code error;
+                telemetry.send(data, error); // Newline-terminated by the channel
+                if (error)
+                {
+                    restore_traces(traces);
+                    reregister = connection_reset(error);
+                    throw boost::system::system_error(error);
+                }
+                std::cout << "Drone " << drone_id << " Sent telemetry data: " << data << std::endl;
+                std::this_thread::sleep_for(settings.telemetry_interval);
+            }
+            socket.close();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Exception in send_telemetry_data (Drone " << drone_id << "): " << e.what() << std::endl;
+            is_connected.store(false);
+            std::chrono::milliseconds delay = backoff.next();
+            std::cerr << "Drone " << drone_id << " retrying in " << delay.count() << " ms" << std::endl;
+            std::this_thread::sleep_for(delay); // Wait before retrying
+
+            // A reset link means the server may have restarted and forgotten this drone;
+            // other failures (refused connects, timeouts) just retry the connection
+            if (reregister && settings.register_with_server)
+                telemetry_port = register_drone(io_context, settings).telemetry_port;
+            reregister = false;
+        }
+    }
+}
+
+// Opens a file connection and asks for an upload slot (see cc_upload.hpp), waiting as
+// long as the server says between attempts. Returns the connection once the server
+// answers GO.
+std::unique_ptr<FileChannel> open_upload(boost::asio::io_context &io_context, const DroneSettings &settings, uint64_t bytes)
+{
+    // A little jitter on every wait keeps drones told the same wait from coming back together
+    std::mt19937 rng(std::random_device{}());
+    std::uniform_real_distribution<double> jitter(0.9, 1.1);
+    tcp::endpoint server_endpoint(boost::asio::ip::make_address(settings.server_ip), settings.file_port);
+    while (true)
+    {
+        std::unique_ptr<FileChannel> channel(new FileChannel(io_context));
+        tcp::socket &socket = channel->transport().socket();
+        socket.connect(server_endpoint);
+
+        // Every drone shares the file port, so the transfer opens by naming its sender
+        boost::system::error_code error;
+        channel->send(cc::format_upload_request(settings.drone_id, bytes, settings.file_priority), error);
+        if (error)
+            throw boost::system::system_error(error);
+
+        std::string reply, rest;
+        bool go = false;
+        uint64_t wait_ms = 0;
+        if (!cc::read_line(socket, reply, rest, 30000) || !cc::parse_upload_reply(reply, go, wait_ms))
+            throw std::runtime_error("no answer to upload request");
+        if (go)
+            return channel;
+
+        socket.close(error);
+        std::cout << "Drone " << settings.drone_id << " Upload deferred by the server for " << wait_ms << " ms." << std::endl;
+        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<long long>(wait_ms * jitter(rng))));
+    }
+}
+
+void send_large_file_tcp(const DroneSettings &settings)
+{
+    int drone_id = settings.drone_id;
+    const std::string &file_path = settings.file_path;
+    while (true) // Infinite loop to periodically send the file
+    {
+        std::this_thread::sleep_for(settings.file_delay);
+
+        if (is_connected.load()) // Only send the file if connected
+        {
+            try
+            {
+                // Large sequential reads (mapped or double-buffered) with drop-behind, see cc_filesource.hpp
+                cc::FileSource file;
+                std::string open_error;
+                if (!file.open(file_path, settings.file_source, &open_error))
+                {
+                    std::cerr << "Drone " << drone_id << " Error opening file: " << open_error << std::endl;
+                    return;
+                }
+
+                boost::asio::io_context io_context;
+                std::unique_ptr<FileChannel> channel = open_upload(io_context, settings, file.size());
+                tcp::socket &socket = channel->transport().socket();
+                std::cout << "Drone " << drone_id << " Connected to server for file transfer." << std::endl;
+
+                const char *chunk;
+                size_t length;
+                while (file.next(chunk, length, settings.chunk_size))
+                {
+                    boost::system::error_code error;
+                    size_t bytes_sent = channel->send(chunk, length, error);
+
+                    if (error)
+                    {
+                        std::cerr << "Drone " << drone_id << " Error sending data: " << error.message() << std::endl;
+                        break;
+                    }
+
+                    std::cout << "Drone " << drone_id << " Sent chunk of " << bytes_sent << " bytes." << std::endl;
+                }
+
+                if (file.failed())
+                    std::cerr << "Drone " << drone_id << " Error reading file: " << file_path << std::endl;
+                std::cout << "Drone " << drone_id << " File transfer completed (" << file.mode_name() << ")." << std::endl;
+
+                // Clean up: Shutdown and close the socket gracefully
+                boost::system::error_code shutdown_error;
+                socket.shutdown(boost::asio::socket_base::shutdown_both, shutdown_error);
+                if (shutdown_error)
+                {
+                    std::cerr << "Drone " << drone_id << " Error during shutdown: " << shutdown_error.message() << std::endl;
+                }
+
+                boost::system::error_code close_error;
+                socket.close(close_error);
+                if (close_error)
+                {
+                    std::cerr << "Drone " << drone_id << " Error during socket close: " << close_error.message() << std::endl;
+                }
+
+                file.close();
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Drone " << drone_id << " Exception: " << e.what() << std::endl;
+            }
+        }
+
+        std::this_thread::sleep_for(settings.file_interval);
+    }
+}
+
+// Settings, with the config file's value (or the default) for anything not on the command line:
+//   id, server, register, registration_port, control_port, telemetry_port, file_port,
+//   telemetry_interval, file_delay, file_interval (seconds), file_path, chunk_size,
+//   file_source (auto|mmap|buffered), file_block, drop_behind, file_priority (low|normal|urgent),
+//   control_buffer, telemetry (tcp|udp), udp_fallback, low_latency, control_core
+DroneSettings load_settings(const cc::Config &config)
+{
+    auto seconds = [&config](const char *key, std::chrono::milliseconds fallback)
+    {
+        return std::chrono::milliseconds(static_cast<long long>(config.get_double(key, fallback.count() / 1000.0) * 1000.0));
+    };
+
+    DroneSettings settings;
+    settings.drone_id = static_cast<int>(config.get_int("id", 0));
+    settings.server_ip = config.get("server", settings.server_ip);
+    settings.register_with_server = config.get_bool("register", true);
+    settings.registration_port = static_cast<unsigned short>(config.get_int("registration_port", settings.registration_port));
+    settings.control_port = static_cast<unsigned short>(config.get_int("control_port", settings.control_port));
+    settings.telemetry_port = static_cast<unsigned short>(config.get_int("telemetry_port", settings.telemetry_port));
+    settings.file_port = static_cast<unsigned short>(config.get_int("file_port", settings.file_port));
+    settings.telemetry_interval = seconds("telemetry_interval", settings.telemetry_interval);
+    settings.file_delay = seconds("file_delay", settings.file_delay);
+    settings.file_interval = seconds("file_interval", settings.file_interval);
+    settings.file_path = config.get("file_path", settings.file_path);
+    settings.chunk_size = static_cast<size_t>(std::max(1L, config.get_int("chunk_size", static_cast<long>(settings.chunk_size))));
+    if (config.has("file_source") && !cc::parse_file_source_mode(config.get("file_source"), settings.file_source.mode))
+        std::cerr << "Unknown file_source (use auto, mmap or buffered): " << config.get("file_source") << std::endl;
+    settings.file_source.block_size = static_cast<size_t>(std::max(4096L, config.get_int("file_block", static_cast<long>(settings.file_source.block_size))));
+    settings.file_source.drop_behind = config.get_bool("drop_behind", true);
+    if (config.has("file_priority") && !cc::parse_upload_priority(config.get("file_priority"), settings.file_priority))
+        std::cerr << "Unknown file_priority (use low, normal or urgent): " << config.get("file_priority") << std::endl;
+    settings.control_buffer = static_cast<size_t>(std::max(64L, config.get_int("control_buffer", static_cast<long>(settings.control_buffer))));
+    settings.datagram_telemetry = config.get("telemetry", "tcp") == "udp";
+    settings.udp_fallback_after = static_cast<int>(std::max(1L, config.get_int("udp_fallback", settings.udp_fallback_after)));
+    settings.latency.busy_poll = config.get_bool("low_latency", false);
+    settings.latency.core = static_cast<int>(config.get_int("control_core", -1));
+    return settings;
+}
+
+int main(int argc, char *argv[])
+{
+    cc::Config config;
+    std::string config_error;
+    if (!config.load(argc, argv, &config_error))
+    {
+        std::cerr << config_error << std::endl;
+        return 1;
+    }
+    DroneSettings settings = load_settings(config);
+
+    boost::asio::io_context io_context;
+    if (settings.register_with_server)
+    {
+        cc::Registration registration = register_drone(io_context, settings);
+        settings.drone_id = registration.drone_id;
+        settings.control_port = registration.control_port;
+        settings.telemetry_port = registration.telemetry_port;
+        settings.file_port = registration.file_port;
+    }
+    else if (settings.drone_id <= 0 || settings.control_port == 0)
+    {
+        std::cerr << "Without registration, id and control_port must be configured" << std::endl;
+        return 1;
+    }
+
+    std::thread control_thread(receive_control_commands, std::ref(io_context), std::cref(settings));
+    std::thread telemetry_thread(send_telemetry_data, std::ref(io_context), std::cref(settings));
+    std::thread file_transfer_thread(send_large_file_tcp, std::cref(settings));
+
+    control_thread.join();
+    telemetry_thread.join();
+    file_transfer_thread.join();
+
+    return 0;
+}
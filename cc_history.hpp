@@ -0,0 +1,539 @@
+#pragma once
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Persisted telemetry history with multi-resolution rollups.
+//
+// Every position sample is appended to its drone's raw series, and folded into 1 s,
+// 1 min and 1 h rollups as it arrives. A rollup bucket is written out once a sample
+// lands in a later bucket; until then it is held in memory and still visible to
+// queries. Each (drone, level) is one append-only file of fixed-size records in time
+// order, <dir>/drone<id>.<raw|1s|1m|1h>, so a time range is found by binary search
+// with pread and a restart just keeps appending.
+//
+// Queries pick the coarsest level that still answers them: a track at one point per
+// minute reads the 1 min rollup rather than 60x as many raw samples. A fleet-wide
+// query scans the drones in parallel across all cores.
+//
+// Raw samples are written from memory at most flush_interval apart (and before every
+// query), so a crash loses at most that much history. Rollup buckets that were still
+// open are rebuilt from the raw samples on the next open().
+namespace cc
+{
+    // One raw sample (count 1, start == last) or one rollup bucket
+    struct HistoryRecord
+    {
+        int64_t start_ns = 0; // Bucket start, wall-clock ns since the epoch; the sample time for raw
+        int64_t last_ns = 0;  // Latest sample in the bucket
+        uint64_t count = 0;
+        double x = 0.0; // Mean position over the bucket
+        double y = 0.0;
+        double altitude = 0.0;
+        double last_x = 0.0; // Position at last_ns
+        double last_y = 0.0;
+        double last_altitude = 0.0;
+    };
+
+    static_assert(sizeof(HistoryRecord) == 72, "history records are stored as-is and must stay 72 bytes");
+
+    constexpr int history_levels = 4;
+    constexpr int64_t history_level_ns[history_levels] = {0, 1000000000ll, 60000000000ll, 3600000000000ll};
+    constexpr const char *history_level_names[history_levels] = {"raw", "1s", "1m", "1h"};
+
+    // Folds b (later) into a
+    inline void merge_history(HistoryRecord &a, const HistoryRecord &b)
+    {
+        uint64_t count = a.count + b.count;
+        double wa = static_cast<double>(a.count) / count, wb = static_cast<double>(b.count) / count;
+        a.x = a.x * wa + b.x * wb;
+        a.y = a.y * wa + b.y * wb;
+        a.altitude = a.altitude * wa + b.altitude * wb;
+        a.count = count;
+        if (b.last_ns >= a.last_ns)
+        {
+            a.last_ns = b.last_ns;
+            a.last_x = b.last_x;
+            a.last_y = b.last_y;
+            a.last_altitude = b.last_altitude;
+        }
+    }
+
+    // A drone's position at (or shortly before) the requested time
+    struct HistoryPosition
+    {
+        int drone_id = -1;
+        int level = 0;
+        HistoryRecord record; // Position is last_x/last_y/last_altitude at last_ns
+    };
+
+    struct HistoryOptions
+    {
+        int64_t flush_interval_ns = 1000000000ll;
+        size_t flush_records = 8192; // Flush early once this many records are waiting
+        size_t query_threads = 0;    // Parallel scan width for fleet queries; 0 = every core
+    };
+
+    class HistoryStore
+    {
+    public:
+        ~HistoryStore() { close(); }
+
+        // Opens (creating if needed) the history directory and picks up the drones already in it
+        bool open(const std::string &directory, const HistoryOptions &options = HistoryOptions(), std::string *error = nullptr)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            directory_ = directory;
+            options_ = options;
+            if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+            {
+                if (error)
+                    *error = directory + ": " + std::strerror(errno);
+                return false;
+            }
+            DIR *dir = ::opendir(directory.c_str());
+            if (!dir)
+            {
+                if (error)
+                    *error = directory + ": " + std::strerror(errno);
+                return false;
+            }
+            while (dirent *entry = ::readdir(dir))
+            {
+                int drone_id;
+                char suffix[8];
+                if (std::sscanf(entry->d_name, "drone%d.%7s", &drone_id, suffix) == 2 && std::strcmp(suffix, "raw") == 0)
+                    recover(index_of(drone_id));
+            }
+            ::closedir(dir);
+
+            // Samples are stamped on the monotonic clock; history is kept in wall-clock time
+            auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            auto steady = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            wall_offset_ns_ = static_cast<int64_t>(wall) - static_cast<int64_t>(steady);
+            last_flush_ns_ = static_cast<int64_t>(wall);
+            open_ = true;
+            return true;
+        }
+
+        // Writes out everything held in memory, including the open rollup buckets
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!open_)
+                return;
+            for (size_t i = 0; i < series_.size(); ++i)
+            {
+                for (int level = 1; level < history_levels; ++level)
+                {
+                    if (series_[i].open[level].count > 0)
+                    {
+                        series_[i].pending[level].push_back(series_[i].open[level]);
+                        series_[i].open[level] = HistoryRecord();
+                        mark_dirty(i);
+                    }
+                }
+            }
+            flush_locked();
+            open_ = false;
+        }
+
+        bool is_open() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return open_;
+        }
+
+        // Records one position sample taken at received_ns on the monotonic clock
+        void record(int drone_id, uint64_t received_ns, double x, double y, double altitude)
+        {
+            record_wall(drone_id, wall_ns(received_ns), x, y, altitude);
+        }
+
+        // Records one position sample stamped in wall-clock ns since the epoch
+        void record_wall(int drone_id, int64_t at_ns, double x, double y, double altitude)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!open_)
+                return;
+            size_t index = index_of(drone_id);
+            Series &series = series_[index];
+
+            // Never step back in time within a series, even across a wall-clock change between runs
+            int64_t ts = std::max(at_ns, series.last_ns);
+            series.last_ns = ts;
+
+            HistoryRecord sample;
+            sample.start_ns = sample.last_ns = ts;
+            sample.count = 1;
+            sample.x = sample.last_x = x;
+            sample.y = sample.last_y = y;
+            sample.altitude = sample.last_altitude = altitude;
+            series.pending[0].push_back(sample);
+            ++pending_records_;
+
+            for (int level = 1; level < history_levels; ++level)
+                fold(series, level, sample);
+            mark_dirty(index);
+
+            if (pending_records_ >= options_.flush_records || ts - last_flush_ns_ >= options_.flush_interval_ns)
+            {
+                flush_locked();
+                last_flush_ns_ = ts;
+            }
+        }
+
+        void flush()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            flush_locked();
+        }
+
+        // The coarsest level whose buckets are no wider than step_ns
+        static int level_for(int64_t step_ns)
+        {
+            int level = 0;
+            while (level + 1 < history_levels && history_level_ns[level + 1] <= step_ns)
+                ++level;
+            return level;
+        }
+
+        // Drone's track over [from_ns, to_ns], at most one point per step_ns (0 = every
+        // sample). Points are read from the coarsest level that resolves step_ns and
+        // merged down to one per step. level is set to the level read.
+        std::vector<HistoryRecord> track(int drone_id, int64_t from_ns, int64_t to_ns, int64_t step_ns, int &level)
+        {
+            level = level_for(step_ns);
+            HistoryRecord open;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                flush_locked();
+                auto it = index_.find(drone_id);
+                if (it == index_.end())
+                    return std::vector<HistoryRecord>();
+                open = series_[it->second].open[level];
+            }
+
+            // A bucket that starts before from_ns may still hold samples inside the range
+            int64_t first = level == 0 ? from_ns : from_ns / history_level_ns[level] * history_level_ns[level];
+            std::vector<HistoryRecord> records = read_range(path_of(drone_id, level), first, to_ns);
+            if (open.count > 0 && open.start_ns >= first && open.start_ns <= to_ns)
+                records.push_back(open);
+            // Coalescing also joins a bucket split across a restart
+            return step_ns > 0 ? coalesce(records, std::max(step_ns, history_level_ns[level])) : records;
+        }
+
+        // Every drone's last known position at or before at_ns, no older than tolerance_ns.
+        // Each drone is read from the coarsest level that has such a sample; drones are
+        // scanned in parallel.
+        std::vector<HistoryPosition> fleet_at(int64_t at_ns, int64_t tolerance_ns)
+        {
+            std::vector<int> drones;
+            std::vector<std::array<HistoryRecord, history_levels>> open;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                flush_locked();
+                for (const Series &series : series_)
+                {
+                    drones.push_back(series.drone_id);
+                    open.emplace_back();
+                    for (int level = 1; level < history_levels; ++level)
+                        open.back()[level] = series.open[level];
+                }
+            }
+
+            std::vector<HistoryPosition> found(drones.size());
+            std::vector<char> hit(drones.size(), 0);
+            int coarsest = level_for(tolerance_ns);
+            auto scan = [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    for (int level = coarsest; level >= 0 && !hit[i]; --level)
+                    {
+                        HistoryRecord record;
+                        if (position_at(drones[i], level, open[i][level], at_ns, record) && at_ns - record.last_ns <= tolerance_ns)
+                        {
+                            found[i] = HistoryPosition{drones[i], level, record};
+                            hit[i] = 1;
+                        }
+                    }
+                }
+            };
+
+            size_t threads = options_.query_threads > 0 ? options_.query_threads : std::max(1u, std::thread::hardware_concurrency());
+            threads = std::min(threads, drones.size());
+            if (threads <= 1)
+            {
+                scan(0, drones.size());
+            }
+            else
+            {
+                std::vector<std::future<void>> tasks;
+                size_t share = (drones.size() + threads - 1) / threads;
+                for (size_t begin = 0; begin < drones.size(); begin += share)
+                    tasks.push_back(std::async(std::launch::async, scan, begin, std::min(drones.size(), begin + share)));
+                for (auto &task : tasks)
+                    task.get();
+            }
+
+            std::vector<HistoryPosition> positions;
+            for (size_t i = 0; i < drones.size(); ++i)
+            {
+                if (hit[i])
+                    positions.push_back(found[i]);
+            }
+            std::sort(positions.begin(), positions.end(), [](const HistoryPosition &a, const HistoryPosition &b)
+                      { return a.drone_id < b.drone_id; });
+            return positions;
+        }
+
+        size_t drones() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return series_.size();
+        }
+
+        // Converts a monotonic timestamp to the wall-clock time history is kept in
+        int64_t wall_ns(uint64_t monotonic_ns) const { return static_cast<int64_t>(monotonic_ns) + wall_offset_ns_; }
+
+    private:
+        struct Series
+        {
+            int drone_id = -1;
+            int64_t last_ns = 0;
+            bool dirty = false;
+            HistoryRecord open[history_levels]; // Bucket being filled per rollup level (count 0 = none)
+            std::vector<HistoryRecord> pending[history_levels];
+        };
+
+        std::string path_of(int drone_id, int level) const
+        {
+            return directory_ + "/drone" + std::to_string(drone_id) + "." + history_level_names[level];
+        }
+
+        size_t index_of(int drone_id)
+        {
+            auto it = index_.find(drone_id);
+            if (it != index_.end())
+                return it->second;
+            series_.emplace_back();
+            series_.back().drone_id = drone_id;
+            index_[drone_id] = series_.size() - 1;
+            return series_.size() - 1;
+        }
+
+        // Adds a sample to the level's open bucket, queueing the bucket once the sample is past it
+        void fold(Series &series, int level, const HistoryRecord &sample)
+        {
+            HistoryRecord &bucket = series.open[level];
+            int64_t start = sample.start_ns / history_level_ns[level] * history_level_ns[level];
+            if (bucket.count > 0 && bucket.start_ns != start)
+            {
+                series.pending[level].push_back(bucket);
+                ++pending_records_;
+                bucket = HistoryRecord();
+            }
+            if (bucket.count == 0)
+            {
+                bucket = sample;
+                bucket.start_ns = start;
+            }
+            else
+            {
+                merge_history(bucket, sample);
+            }
+        }
+
+        // Rebuilds the rollups a previous run had not written out (its open buckets) from
+        // the raw samples after each level's last stored bucket
+        void recover(size_t index)
+        {
+            Series &series = series_[index];
+            HistoryRecord last;
+            if (read_last(path_of(series.drone_id, 0), last))
+                series.last_ns = last.last_ns;
+            for (int level = 1; level < history_levels; ++level)
+            {
+                int64_t from = read_last(path_of(series.drone_id, level), last) ? last.start_ns + history_level_ns[level] : INT64_MIN + 1;
+                for (const HistoryRecord &sample : read_range(path_of(series.drone_id, 0), from, INT64_MAX))
+                    fold(series, level, sample);
+            }
+            mark_dirty(index);
+        }
+
+        void mark_dirty(size_t index)
+        {
+            if (!series_[index].dirty)
+            {
+                series_[index].dirty = true;
+                dirty_.push_back(index);
+            }
+        }
+
+        // Appends each dirty series' pending records to its files, one write per file
+        void flush_locked()
+        {
+            for (size_t index : dirty_)
+            {
+                Series &series = series_[index];
+                for (int level = 0; level < history_levels; ++level)
+                {
+                    std::vector<HistoryRecord> &pending = series.pending[level];
+                    if (pending.empty())
+                        continue;
+                    int fd = ::open(path_of(series.drone_id, level).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+                    if (fd >= 0)
+                    {
+                        const char *data = reinterpret_cast<const char *>(pending.data());
+                        size_t left = pending.size() * sizeof(HistoryRecord);
+                        while (left > 0)
+                        {
+                            ssize_t written = ::write(fd, data, left);
+                            if (written < 0 && errno == EINTR)
+                                continue;
+                            if (written <= 0)
+                                break;
+                            data += written;
+                            left -= static_cast<size_t>(written);
+                        }
+                        ::close(fd);
+                    }
+                    pending.clear();
+                }
+                series.dirty = false;
+            }
+            dirty_.clear();
+            pending_records_ = 0;
+        }
+
+        static bool read_at(int fd, uint64_t index, HistoryRecord &record)
+        {
+            return ::pread(fd, &record, sizeof(record), static_cast<off_t>(index * sizeof(record))) == static_cast<ssize_t>(sizeof(record));
+        }
+
+        static uint64_t record_count(int fd)
+        {
+            struct stat info;
+            return ::fstat(fd, &info) == 0 ? static_cast<uint64_t>(info.st_size) / sizeof(HistoryRecord) : 0;
+        }
+
+        // Index of the first record starting after ns (binary search on start_ns)
+        static uint64_t upper_bound(int fd, uint64_t count, int64_t ns)
+        {
+            uint64_t low = 0, high = count;
+            HistoryRecord record;
+            while (low < high)
+            {
+                uint64_t middle = low + (high - low) / 2;
+                if (!read_at(fd, middle, record))
+                    return middle;
+                if (record.start_ns <= ns)
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+            return low;
+        }
+
+        static bool read_last(const std::string &path, HistoryRecord &record)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return false;
+            uint64_t count = record_count(fd);
+            bool found = count > 0 && read_at(fd, count - 1, record);
+            ::close(fd);
+            return found;
+        }
+
+        // Records with start_ns in [from_ns, to_ns], read in large sequential blocks
+        static std::vector<HistoryRecord> read_range(const std::string &path, int64_t from_ns, int64_t to_ns)
+        {
+            std::vector<HistoryRecord> records;
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return records;
+            uint64_t count = record_count(fd);
+            uint64_t begin = upper_bound(fd, count, from_ns - 1);
+            uint64_t end = upper_bound(fd, count, to_ns);
+            if (end > begin)
+            {
+                records.resize(static_cast<size_t>(end - begin));
+                ssize_t length = ::pread(fd, records.data(), records.size() * sizeof(HistoryRecord), static_cast<off_t>(begin * sizeof(HistoryRecord)));
+                records.resize(length > 0 ? static_cast<size_t>(length) / sizeof(HistoryRecord) : 0);
+            }
+            ::close(fd);
+            return records;
+        }
+
+        // Latest sample at or before at_ns in one level of a drone's history
+        bool position_at(int drone_id, int level, const HistoryRecord &open, int64_t at_ns, HistoryRecord &out) const
+        {
+            if (level > 0 && open.count > 0 && open.last_ns <= at_ns)
+            {
+                out = open; // The open bucket is newer than anything on disk
+                return true;
+            }
+            int fd = ::open(path_of(drone_id, level).c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return false;
+            uint64_t index = upper_bound(fd, record_count(fd), at_ns);
+            bool found = false;
+            // The bucket holding at_ns may end after it; then the one before is the answer
+            for (int back = 0; back < 2 && index > 0 && !found; ++back)
+            {
+                --index;
+                found = read_at(fd, index, out) && out.last_ns <= at_ns;
+            }
+            ::close(fd);
+            return found;
+        }
+
+        // Merges records into one per step-aligned window
+        static std::vector<HistoryRecord> coalesce(const std::vector<HistoryRecord> &records, int64_t step_ns)
+        {
+            std::vector<HistoryRecord> merged;
+            for (const HistoryRecord &record : records)
+            {
+                int64_t window = record.start_ns / step_ns * step_ns;
+                if (!merged.empty() && merged.back().start_ns == window)
+                {
+                    merge_history(merged.back(), record);
+                    continue;
+                }
+                merged.push_back(record);
+                merged.back().start_ns = window;
+            }
+            return merged;
+        }
+
+        mutable std::mutex mutex_;
+        std::string directory_;
+        HistoryOptions options_;
+        bool open_ = false;
+        int64_t wall_offset_ns_ = 0;
+        int64_t last_flush_ns_ = 0;
+        size_t pending_records_ = 0;
+
+        std::vector<Series> series_;
+        std::unordered_map<int, size_t> index_;
+        std::vector<size_t> dirty_;
+    };
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <sys/socket.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include "cc_affinity.hpp"
+
+// Opt-in low-latency receive path for the control channel.
+//
+// Default mode blocks in receive_from and relies on the scheduler to wake the
+// thread when a datagram arrives. Low-latency mode instead keeps the control
+// thread on a dedicated core, spinning on a non-blocking socket, and asks the
+// kernel to busy-poll the NIC queue (SO_BUSY_POLL) so a command is picked up
+// without an interrupt/wakeup round trip. It burns one core while enabled.
+namespace cc
+{
+    struct ControlLatencyOptions
+    {
+        bool busy_poll = false;
+        int core = -1;          // Core for the control thread (-1 = unpinned)
+        int busy_poll_us = 50;  // SO_BUSY_POLL budget per poll
+    };
+
+    // Applies the options to the control socket. Must be called on the control thread
+    // so the pinning applies to the thread that will spin.
+    inline void configure_control_socket(boost::asio::ip::udp::socket &socket, const ControlLatencyOptions &options)
+    {
+        if (!options.busy_poll)
+            return;
+
+        pin_current_thread(options.core, "control receiver");
+        socket.non_blocking(true);
+
+#ifdef SO_BUSY_POLL
+        int budget = options.busy_poll_us;
+        if (setsockopt(socket.native_handle(), SOL_SOCKET, SO_BUSY_POLL, &budget, sizeof(budget)) != 0)
+            std::cerr << "SO_BUSY_POLL not applied (" << std::strerror(errno) << "), spinning in user space only" << std::endl;
+#endif
+        std::cout << "Control channel in busy-poll low-latency mode" << std::endl;
+    }
+
+    // Receives one datagram. In busy-poll mode the socket is non-blocking and this spins
+    // until data arrives; otherwise it is an ordinary blocking receive.
+    template <typename MutableBuffer>
+    size_t receive_control_datagram(boost::asio::ip::udp::socket &socket, const MutableBuffer &buffer,
+                                    boost::asio::ip::udp::endpoint &sender, const ControlLatencyOptions &options,
+                                    boost::system::error_code &error)
+    {
+        if (!options.busy_poll)
+            return socket.receive_from(buffer, sender, 0, error);
+
+        while (true)
+        {
+            size_t length = socket.receive_from(buffer, sender, 0, error);
+            if (error != boost::asio::error::would_block && error != boost::asio::error::try_again)
+                return length;
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+    }
+}
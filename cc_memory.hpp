@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Memory for many mostly-idle connections.
+//
+//   SlabPool<T>  fixed-size session objects carved out of large slabs, recycled
+//                through a free list, so a session costs sizeof(T) and no
+//                per-connection heap churn
+//   BufferPool   I/O buffers shared by every session and lent out only for the
+//                duration of a read; an idle session holds none
+//   Arena        bump allocator for temporaries that live for one message or one
+//                read, released all at once with reset()
+namespace cc
+{
+    // Not thread-safe: each pool belongs to one thread (a worker's io_context).
+    // The counters may be read from other threads for reporting.
+    template <typename T, size_t SlabObjects = 256>
+    class SlabPool
+    {
+    public:
+        SlabPool() = default;
+        SlabPool(const SlabPool &) = delete;
+        SlabPool &operator=(const SlabPool &) = delete;
+
+        template <typename... Args>
+        T *create(Args &&...args)
+        {
+            Slot *slot = free_;
+            if (!slot)
+            {
+                grow();
+                slot = free_;
+            }
+            free_ = slot->next;
+            T *object = new (slot->storage) T(std::forward<Args>(args)...);
+            live_.fetch_add(1, std::memory_order_relaxed);
+            return object;
+        }
+
+        void destroy(T *object)
+        {
+            object->~T();
+            Slot *slot = reinterpret_cast<Slot *>(object);
+            slot->next = free_;
+            free_ = slot;
+            live_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        static constexpr size_t slot_size() { return sizeof(Slot); }
+        size_t live() const { return live_.load(std::memory_order_relaxed); }
+        size_t reserved_bytes() const { return slabs_.load(std::memory_order_relaxed) * SlabObjects * sizeof(Slot); }
+
+    private:
+        union Slot
+        {
+            Slot *next;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        void grow()
+        {
+            std::unique_ptr<Slot[]> slab(new Slot[SlabObjects]);
+            for (size_t i = 0; i < SlabObjects; ++i)
+                slab[i].next = i + 1 < SlabObjects ? &slab[i + 1] : free_;
+            free_ = &slab[0];
+            storage_.push_back(std::move(slab));
+            slabs_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::vector<std::unique_ptr<Slot[]>> storage_;
+        Slot *free_ = nullptr;
+        std::atomic<size_t> live_{0};
+        std::atomic<size_t> slabs_{0};
+    };
+
+    class BufferPool;
+
+    // A buffer on loan from a BufferPool; returned when the handle is destroyed
+    class PooledBuffer
+    {
+    public:
+        PooledBuffer() = default;
+        PooledBuffer(BufferPool *pool, char *data, size_t size) : pool_(pool), data_(data), size_(size) {}
+        PooledBuffer(PooledBuffer &&other) noexcept { swap(other); }
+        PooledBuffer &operator=(PooledBuffer &&other) noexcept
+        {
+            PooledBuffer released(std::move(other));
+            swap(released);
+            return *this;
+        }
+        PooledBuffer(const PooledBuffer &) = delete;
+        PooledBuffer &operator=(const PooledBuffer &) = delete;
+        inline ~PooledBuffer();
+
+        char *data() const { return data_; }
+        size_t size() const { return size_; }
+
+    private:
+        void swap(PooledBuffer &other)
+        {
+            std::swap(pool_, other.pool_);
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+        }
+
+        BufferPool *pool_ = nullptr;
+        char *data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    // Thread-safe pool of equally sized buffers. At most max_cached idle buffers are
+    // kept for reuse; the rest go back to the allocator.
+    class BufferPool
+    {
+    public:
+        explicit BufferPool(size_t buffer_size = 4096, size_t max_cached = 256)
+            : buffer_size_(buffer_size), max_cached_(max_cached) {}
+
+        ~BufferPool()
+        {
+            for (char *buffer : free_)
+                delete[] buffer;
+        }
+
+        PooledBuffer acquire()
+        {
+            char *buffer = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!free_.empty())
+                {
+                    buffer = free_.back();
+                    free_.pop_back();
+                }
+            }
+            if (!buffer)
+                buffer = new char[buffer_size_];
+            size_t lent = lent_.fetch_add(1, std::memory_order_relaxed) + 1;
+            size_t peak = peak_lent_.load(std::memory_order_relaxed);
+            while (lent > peak && !peak_lent_.compare_exchange_weak(peak, lent, std::memory_order_relaxed))
+            {
+            }
+            return PooledBuffer(this, buffer, buffer_size_);
+        }
+
+        size_t buffer_size() const { return buffer_size_; }
+        size_t lent() const { return lent_.load(std::memory_order_relaxed); }
+        size_t peak_lent() const { return peak_lent_.load(std::memory_order_relaxed); }
+
+        size_t cached() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return free_.size();
+        }
+
+    private:
+        friend class PooledBuffer;
+
+        void release(char *buffer)
+        {
+            lent_.fetch_sub(1, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (free_.size() < max_cached_)
+                {
+                    free_.push_back(buffer);
+                    return;
+                }
+            }
+            delete[] buffer;
+        }
+
+        size_t buffer_size_;
+        size_t max_cached_;
+        mutable std::mutex mutex_;
+        std::vector<char *> free_;
+        std::atomic<size_t> lent_{0};
+        std::atomic<size_t> peak_lent_{0};
+    };
+
+    PooledBuffer::~PooledBuffer()
+    {
+        if (pool_ && data_)
+            pool_->release(data_);
+    }
+
+    // Bump allocator. Memory is only reclaimed by reset(), which keeps the first
+    // chunk so a steady-state arena never touches the heap. Not thread-safe.
+    class Arena
+    {
+    public:
+        explicit Arena(size_t chunk_size = 4096) : chunk_size_(chunk_size) {}
+
+        void *allocate(size_t size, size_t align = alignof(std::max_align_t))
+        {
+            size_t offset = (used_ + align - 1) & ~(align - 1);
+            if (chunks_.empty() || offset + size > capacity_)
+            {
+                size_t capacity = std::max(chunk_size_, size + align);
+                chunks_.emplace_back(new char[capacity]);
+                capacity_ = capacity;
+                offset = 0;
+            }
+            used_ = offset + size;
+            return chunks_.back().get() + offset;
+        }
+
+        // NUL-terminated copy, for C parsing routines (strtod and friends) on unterminated input
+        const char *copy_string(const char *data, size_t length)
+        {
+            char *copy = static_cast<char *>(allocate(length + 1, 1));
+            std::memcpy(copy, data, length);
+            copy[length] = '\0';
+            return copy;
+        }
+
+        void reset()
+        {
+            if (chunks_.size() > 1)
+            {
+                // Keep one chunk large enough for the biggest request seen
+                std::unique_ptr<char[]> last = std::move(chunks_.back());
+                chunks_.clear();
+                chunks_.push_back(std::move(last));
+            }
+            used_ = 0;
+        }
+
+    private:
+        size_t chunk_size_;
+        std::vector<std::unique_ptr<char[]>> chunks_;
+        size_t capacity_ = 0;
+        size_t used_ = 0;
+    };
+}
@@ -5,61 +5,511 @@
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <unistd.h>
+#include <set>
+#include <chrono>
+#include <iomanip>
+#include "cc_capture.hpp"
+#include "cc_channel.hpp"
+#include "cc_commands.hpp"
+#include "cc_spatial.hpp"
+#include "cc_telemetry.hpp"
+#include "cc_pipeline.hpp"
+#include "cc_trace.hpp"
+#include "cc_admission.hpp"
+#include "cc_memory.hpp"
+#include "cc_analytics.hpp"
+#include "cc_sequence.hpp"
+#include "cc_config.hpp"
+#include "cc_registration.hpp"
+#include "cc_history.hpp"
+#include "cc_upload.hpp"
+#include <unordered_map>
 
 using boost::asio::ip::tcp;
 using boost::asio::ip::udp;
 
-void handle_telemetry_data(tcp::socket socket)
+// Wire configuration. Drones talk to this server in plaintext on every channel.
+// Telemetry sessions are event-driven, so they use the telemetry framing directly
+// rather than a blocking channel.
+typedef cc::Channel<cc::TcpStream, cc::LineFraming, cc::NoCipher, cc::StringCodec> TelemetryChannel;
+typedef cc::Channel<cc::UdpDatagram, cc::DatagramFraming, cc::NoCipher, cc::CommandCodec> CommandChannel;
+typedef cc::Channel<cc::TcpStream, cc::RawFraming, cc::NoCipher, cc::StringCodec> FileChannel;
+
+// Optional capture of all three channels (enabled with --record <path>)
+cc::CaptureWriter recorder;
+
+// Latest position of every drone, for proximity and conflict queries
+cc::SpatialIndex fleet_index(50.0);
+
+// Live per-drone metrics (speed, distance, telemetry rate and jitter), updated per sample
+std::unique_ptr<cc::DroneAnalytics> analytics;
+uint64_t stale_after_ns = 600000000000ull; // Drones silent for longer count as stale
+
+// Every known drone and where its commands go; filled by registration and the config
+cc::DroneRegistry registry;
+
+// Gap, reorder and duplicate detection for numbered telemetry samples
+cc::SequenceTracker sequences;
+
+// Decides when each drone may upload its file, so uploads keep ingest busy without piling up
+cc::UploadScheduler uploads;
+const uint64_t upload_standby_ms = 20000; // Longest a request is held open waiting for a slot
+
+// Persisted positions with 1 s / 1 min / 1 h rollups, for track and fleet-at-time queries (--history <dir>)
+cc::HistoryStore history;
+
+// Telemetry ingest runs as a pipeline so a slow sink never stalls a socket:
+//   socket threads -> decode -> state update -> sinks
+struct RawTelemetry
+{
+    std::string line;
+    int worker_id = 0;
+    uint64_t received_ns = 0; // Monotonic time the line came off the socket
+    bool datagram = false;
+};
+
+struct DecodedTelemetry
+{
+    std::string text;
+    cc::TelemetrySample sample;
+    int worker_id = 0;
+    uint64_t received_ns = 0;
+    bool datagram = false;
+    bool latest = true; // False for a late sample: counted and traced, but it never moves the drone
+};
+
+// Command-to-effect latency traces, completed from the ids drones echo in telemetry
+cc::LatencyTracer tracer;
+
+std::unique_ptr<cc::Stage<RawTelemetry>> decode_stage;
+std::unique_ptr<cc::Stage<DecodedTelemetry>> state_stage;
+std::unique_ptr<cc::Stage<DecodedTelemetry>> sink_stage;
+
+void start_ingest_pipeline(const cc::StageOptions &options, const std::vector<int> &cores)
+{
+    auto options_for = [&options, &cores](size_t stage)
+    {
+        cc::StageOptions stage_options = options;
+        stage_options.core = stage < cores.size() ? cores[stage] : -1;
+        return stage_options;
+    };
+    decode_stage.reset(new cc::Stage<RawTelemetry>("decode", options_for(0)));
+    state_stage.reset(new cc::Stage<DecodedTelemetry>("state", options_for(1)));
+    sink_stage.reset(new cc::Stage<DecodedTelemetry>("sink", options_for(2)));
+
+    sink_stage->start([](DecodedTelemetry &item)
+                      {
+                          if (item.latest && item.sample.drone_id >= 0 && item.sample.has_position)
+                              history.record(item.sample.drone_id, item.received_ns, item.sample.x, item.sample.y, item.sample.altitude);
+                          std::cout << "[worker " << item.worker_id << "] Received " << (item.datagram ? "datagram " : "")
+                                    << "telemetry" << (item.latest ? "" : " (late)") << ": " << item.text << std::endl; });
+
+    state_stage->start([](DecodedTelemetry &item)
+                       {
+                           // Latest sample wins: duplicates are dropped and late samples never overwrite a newer position
+                           if (item.sample.drone_id >= 0 && item.sample.seq > 0)
+                           {
+                               cc::SequenceVerdict verdict = sequences.observe(item.sample.drone_id, item.sample.session, item.sample.seq);
+                               if (verdict == cc::SequenceVerdict::Duplicate || verdict == cc::SequenceVerdict::Stale)
+                                   return;
+                               item.latest = cc::is_latest(verdict);
+                           }
+                           if (item.latest && item.sample.drone_id >= 0 && item.sample.has_position)
+                           {
+                               fleet_index.submit(item.sample.drone_id, item.sample.x, item.sample.y);
+                               analytics->record_sample(item.sample.drone_id, item.sample.x, item.sample.y, item.received_ns);
+                           }
+                           tracer.telemetry_received(item.text, item.received_ns);
+                           sink_stage->push(std::move(item)); });
+
+    decode_stage->start([](RawTelemetry &raw)
+                        {
+                            DecodedTelemetry decoded;
+                            decoded.sample = cc::parse_telemetry(raw.line);
+                            decoded.text = std::move(raw.line);
+                            decoded.worker_id = raw.worker_id;
+                            decoded.received_ns = raw.received_ns;
+                            decoded.datagram = raw.datagram;
+                            state_stage->push(std::move(decoded)); });
+}
+
+// Upstream first, so each stage drains into one that is still running
+void stop_ingest_pipeline()
+{
+    decode_stage->stop();
+    state_stage->stop();
+    sink_stage->stop();
+}
+
+// SO_REUSEPORT is not wrapped by Asio
+typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port;
+
+// A connection accepted by one worker that belongs to another worker's drone
+struct Handoff
+{
+    enum Kind
+    {
+        Telemetry,
+        File
+    } kind;
+    int fd;
+    std::string pending; // Bytes already read while identifying the drone
+    int drone_id;        // Sender of a file transfer
+};
+
+struct Worker;
+
+// One telemetry connection. Sessions are slab-allocated by their worker and driven by
+// its io_context: between reads a session holds no buffer and no thread, only the
+// socket and a line tail, which stays empty (and heap-free) unless a read split a line.
+struct TelemetrySession
+{
+    TelemetrySession(boost::asio::io_context &io_context, Worker *worker) : worker(worker), socket(io_context) {}
+
+    Worker *worker;
+    tcp::socket socket;
+    std::string carry; // Unterminated tail of the last read
+    uint32_t capture_session = 0;
+    unsigned short port = 0;
+    bool routed = false; // Set once the first line has identified the owning worker
+};
+
+// Each worker owns a shard of the fleet (drone_id % worker count): its telemetry
+// sessions, file transfers and command sends all run under that worker. Workers
+// share the listening ports through SO_REUSEPORT and the kernel spreads incoming
+// connections across them; a connection that lands on the wrong worker is handed
+// over to the owner before any of its data is processed.
+struct Worker
+{
+    int id = 0;
+    boost::asio::io_context io_context; // Telemetry sessions, handoffs and command sends; run by one thread
+    cc::SlabPool<TelemetrySession> sessions;
+    cc::Arena scratch; // Per-read temporaries, reset before each use
+    std::atomic<size_t> telemetry_sessions{0};
+    std::atomic<size_t> file_sessions{0};
+    std::atomic<size_t> handed_over{0};
+
+    // Datagram telemetry: one socket per worker on the telemetry port, also run by io_context.
+    // Senders are acknowledged at most once per ack interval (keyed by address and port).
+    std::unique_ptr<udp::socket> datagrams;
+    std::unordered_map<uint64_t, uint64_t> acked_ns;
+    uint32_t datagram_capture = 0;
+    std::atomic<size_t> datagrams_received{0};
+};
+
+std::vector<std::unique_ptr<Worker>> workers;
+
+Worker &owner_of(int drone_id)
+{
+    size_t index = static_cast<size_t>(drone_id < 0 ? -drone_id : drone_id) % workers.size();
+    return *workers[index];
+}
+
+// Listen backlog, accept batching and session admission rate (see cc_admission.hpp)
+cc::AdmissionOptions admission;
+
+// Opens a listening acceptor; with share_port set, other workers may bind the same port
+tcp::acceptor open_acceptor(boost::asio::io_context &io_context, unsigned short port, bool share_port)
+{
+    tcp::acceptor acceptor(io_context);
+    tcp::endpoint endpoint(tcp::v4(), port);
+    acceptor.open(endpoint.protocol());
+    acceptor.set_option(tcp::acceptor::reuse_address(true));
+    if (share_port)
+        acceptor.set_option(reuse_port(true));
+    acceptor.bind(endpoint);
+    acceptor.listen(admission.listen_backlog);
+    return acceptor;
+}
+
+// I/O buffers shared by every session, lent out only while a read is being drained
+std::unique_ptr<cc::BufferPool> io_buffers;
+
+// A telemetry line longer than this without a newline ends the session
+const size_t max_telemetry_line = 64 * 1024;
+
+// Reads drained from one session per wakeup before other sessions get a turn
+const int max_reads_per_wakeup = 16;
+
+void adopt_handoff(Worker &worker, Handoff handoff);
+
+// Queues a connection on the target worker's io_context; it is adopted on that worker's thread
+void hand_over(Worker &target, Handoff handoff)
+{
+    boost::asio::post(target.io_context, [&target, handoff = std::move(handoff)]() mutable
+                      { adopt_handoff(target, std::move(handoff)); });
+}
+
+void read_telemetry(TelemetrySession *session);
+
+// Datagram senders are acknowledged at most this often; a drone that hears nothing falls back to TCP
+const uint64_t datagram_ack_interval_ns = 1000000000ull;
+const size_t max_acked_senders = 65536;
+
+// Registered drones get "ACK". Anyone else gets "NACK", which tells a drone this server
+// does not know it (e.g. after a restart) and it must register before commands can reach it.
+void acknowledge_datagram(Worker &worker, const udp::endpoint &sender, const std::string &line, uint64_t now)
+{
+    uint64_t key = (static_cast<uint64_t>(sender.address().to_v4().to_uint()) << 16) | sender.port();
+    uint64_t &last = worker.acked_ns[key];
+    if (last != 0 && now - last < datagram_ack_interval_ns)
+        return;
+    last = now;
+
+    cc::DroneAddress known;
+    bool registered = registry.lookup(cc::parse_telemetry(line.c_str()).drone_id, known);
+    const char *reply = registered ? "ACK" : "NACK";
+    boost::system::error_code ignored;
+    worker.datagrams->send_to(boost::asio::buffer(reply, std::strlen(reply)), sender, 0, ignored);
+
+    // Forget senders that have gone quiet so the table stays bounded
+    if (worker.acked_ns.size() > max_acked_senders)
+    {
+        for (auto it = worker.acked_ns.begin(); it != worker.acked_ns.end();)
+            it = now - it->second > 60 * datagram_ack_interval_ns ? worker.acked_ns.erase(it) : std::next(it);
+    }
+}
+
+void read_datagrams(Worker &worker);
+
+// Each datagram is one telemetry line. Datagrams from one drone always reach the same
+// worker (SO_REUSEPORT hashes the address pair), and sequence checks run in the single
+// state stage, so datagrams need no ownership routing.
+void drain_datagrams(Worker &worker)
+{
+    cc::PooledBuffer buffer = io_buffers->acquire();
+    udp::endpoint sender;
+    for (int reads = 0; reads < max_reads_per_wakeup; ++reads)
+    {
+        boost::system::error_code error;
+        size_t length = worker.datagrams->receive_from(boost::asio::buffer(buffer.data(), buffer.size()), sender, 0, error);
+        if (error == boost::asio::error::would_block || error == boost::asio::error::try_again)
+            break;
+        if (error)
+        {
+            std::cerr << "[worker " << worker.id << "] Error receiving telemetry datagram: " << error.message() << std::endl;
+            break;
+        }
+
+        uint64_t received_ns = cc::monotonic_ns();
+        if (length > 0 && buffer.data()[length - 1] == '\n')
+            length--;
+        std::string line(buffer.data(), length);
+        if (recorder.is_open())
+        {
+            // Recorded as newline-terminated lines so a capture replays over either transport
+            std::string recorded = line + '\n';
+            recorder.data(worker.datagram_capture, cc::CaptureChannel::Telemetry, worker.datagrams->local_endpoint().port(), recorded.data(), recorded.size());
+        }
+        worker.datagrams_received++;
+        acknowledge_datagram(worker, sender, line, received_ns);
+        decode_stage->push(RawTelemetry{std::move(line), worker.id, received_ns, true});
+    }
+    read_datagrams(worker);
+}
+
+void read_datagrams(Worker &worker)
+{
+    worker.datagrams->async_wait(udp::socket::wait_read, [&worker](const boost::system::error_code &error)
+                                 {
+                                     if (error)
+                                     {
+                                         std::cerr << "[worker " << worker.id << "] Telemetry datagram socket closed: " << error.message() << std::endl;
+                                         return;
+                                     }
+                                     drain_datagrams(worker); });
+}
+
+void start_datagram_telemetry(Worker &worker, unsigned short port)
 {
     try
     {
-        boost::asio::streambuf buffer;
+        udp::endpoint endpoint(udp::v4(), port);
+        worker.datagrams.reset(new udp::socket(worker.io_context));
+        worker.datagrams->open(endpoint.protocol());
+        worker.datagrams->set_option(udp::socket::reuse_address(true));
+        if (workers.size() > 1)
+            worker.datagrams->set_option(reuse_port(true));
+        worker.datagrams->set_option(boost::asio::socket_base::receive_buffer_size(4 * 1024 * 1024));
+        worker.datagrams->bind(endpoint);
+        worker.datagrams->non_blocking(true);
+        worker.datagram_capture = recorder.open_session(cc::CaptureChannel::Telemetry, port);
+        std::cout << "[worker " << worker.id << "] Telemetry datagrams accepted on UDP port " << port << std::endl;
+        read_datagrams(worker);
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "[worker " << worker.id << "] Datagram telemetry disabled: " << e.what() << std::endl;
+        worker.datagrams.reset();
+    }
+}
+
+void begin_telemetry_session(TelemetrySession *session)
+{
+    session->routed = true;
+    session->port = session->socket.local_endpoint().port();
+    session->capture_session = recorder.open_session(cc::CaptureChannel::Telemetry, session->port);
+    session->worker->telemetry_sessions++;
+}
+
+void close_telemetry_session(TelemetrySession *session)
+{
+    Worker &worker = *session->worker;
+    if (session->routed)
+    {
+        recorder.close_session(session->capture_session, cc::CaptureChannel::Telemetry, session->port);
+        worker.telemetry_sessions--;
+    }
+    boost::system::error_code ignored;
+    session->socket.close(ignored);
+    worker.sessions.destroy(session);
+}
+
+// Splits complete lines off a read and hands them to the pipeline; an unterminated tail waits in carry
+void process_telemetry(TelemetrySession *session, const char *data, size_t length, uint64_t received_ns)
+{
+    if (recorder.is_open())
+        recorder.data(session->capture_session, cc::CaptureChannel::Telemetry, session->port, data, length);
+
+    // Decoding, state updates and printing happen off this thread
+    TelemetryChannel::framing::split(session->carry, data, length, [session, received_ns](std::string line)
+                                     { decode_stage->push(RawTelemetry{std::move(line), session->worker->id, received_ns}); });
+}
+
+// Until the first line arrives a new session only accumulates bytes. That line says
+// which drone connected, and so which worker must own the session.
+// Returns false if the session was handed to another worker.
+bool route_telemetry(TelemetrySession *session, const char *data, size_t length)
+{
+    session->carry.append(data, length);
+    size_t newline = session->carry.find('\n');
+    if (newline == std::string::npos)
+        return true;
+
+    Worker &worker = *session->worker;
+    worker.scratch.reset();
+    int drone_id = cc::parse_telemetry(worker.scratch.copy_string(session->carry.data(), newline)).drone_id;
+    Worker &owner = drone_id < 0 ? worker : owner_of(drone_id);
+    if (&owner != &worker)
+    {
+        worker.handed_over++;
+        hand_over(owner, Handoff{Handoff::Telemetry, session->socket.release(), std::move(session->carry), drone_id});
+        worker.sessions.destroy(session);
+        return false;
+    }
+
+    std::string pending = std::move(session->carry);
+    session->carry = std::string();
+    begin_telemetry_session(session);
+    process_telemetry(session, pending.data(), pending.size(), cc::monotonic_ns());
+    return true;
+}
+
+// Reads whatever the socket has, with a pooled buffer borrowed for just this drain
+void drain_telemetry(TelemetrySession *session)
+{
+    cc::PooledBuffer buffer = io_buffers->acquire();
+    for (int reads = 0; reads < max_reads_per_wakeup; ++reads)
+    {
         boost::system::error_code error;
+        size_t length = session->socket.read_some(boost::asio::buffer(buffer.data(), buffer.size()), error);
+        if (error == boost::asio::error::would_block || error == boost::asio::error::try_again)
+            break;
+        if (error == boost::asio::error::eof)
+        {
+            std::cout << "Client disconnected." << std::endl;
+            close_telemetry_session(session);
+            return;
+        }
+        if (error)
+        {
+            std::cerr << "Exception in telemetry handler: " << error.message() << std::endl;
+            close_telemetry_session(session);
+            return;
+        }
 
-        while (true)
+        if (!session->routed)
         {
-            // Read data until a newline character is encountered
-            size_t len = boost::asio::read_until(socket, buffer, '\n', error);
+            if (!route_telemetry(session, buffer.data(), length))
+                return;
+        }
+        else
+        {
+            process_telemetry(session, buffer.data(), length, cc::monotonic_ns());
+        }
 
-            if (error == boost::asio::error::eof)
-            {
-                std::cout << "Client disconnected." << std::endl;
-                break; // Connection closed cleanly by peer.
-            }
-            else if (error)
-            {
-                throw boost::system::system_error(error); // Handle other errors
-            }
+        if (session->carry.size() > max_telemetry_line)
+        {
+            std::cerr << "Telemetry line exceeds " << max_telemetry_line << " bytes, closing session" << std::endl;
+            close_telemetry_session(session);
+            return;
+        }
+    }
+    read_telemetry(session);
+}
 
-            // Convert buffer data to string
-            std::istream is(&buffer);
-            std::string data;
-            std::getline(is, data);
+// Waits for the socket to become readable without holding a buffer
+void read_telemetry(TelemetrySession *session)
+{
+    session->socket.async_wait(tcp::socket::wait_read, [session](const boost::system::error_code &error)
+                               {
+                                   if (error)
+                                   {
+                                       close_telemetry_session(session);
+                                       return;
+                                   }
+                                   drain_telemetry(session); });
+}
 
-            std::cout << "Received telemetry: " << data << std::endl;
+// Runs on the worker's io_context. Handed-over sessions arrive already routed, with
+// the bytes the accepting worker read while identifying the drone.
+void adopt_telemetry_session(Worker &worker, int fd, std::string pending, bool routed)
+{
+    TelemetrySession *session = worker.sessions.create(worker.io_context, &worker);
+    try
+    {
+        session->socket.assign(tcp::v4(), fd);
+        session->socket.non_blocking(true);
+        if (routed)
+        {
+            begin_telemetry_session(session);
+            process_telemetry(session, pending.data(), pending.size(), cc::monotonic_ns());
         }
     }
     catch (std::exception &e)
     {
-        std::cerr << "Exception in telemetry handler: " << e.what() << std::endl;
+        std::cerr << "[worker " << worker.id << "] Failed to adopt telemetry session: " << e.what() << std::endl;
+        if (!session->socket.is_open())
+            ::close(fd);
+        close_telemetry_session(session);
+        return;
     }
+    read_telemetry(session);
 }
 
-void start_telemetry_server(unsigned short port)
+void start_telemetry_server(unsigned short port, int worker_id)
 {
     try
     {
         boost::asio::io_context io_context;
-        tcp::acceptor acceptor(io_context, tcp::endpoint(tcp::v4(), port));
-        std::cout << "Telemetry server listening on port " << port << std::endl;
+        tcp::acceptor acceptor = open_acceptor(io_context, port, workers.size() > 1);
+        std::cout << "[worker " << worker_id << "] Telemetry server listening on port " << port << std::endl;
 
-        while (true)
-        {
-            tcp::socket socket(io_context);
-            acceptor.accept(socket);
-            std::cout << "New telemetry client connected!" << std::endl;
-            std::thread(handle_telemetry_data, std::move(socket)).detach();
-        }
+        cc::run_batched_accept(acceptor, admission, [worker_id](tcp::socket socket)
+                               {
+                                   std::cout << "[worker " << worker_id << "] New telemetry client connected!" << std::endl;
+                                   Worker &worker = *workers[worker_id];
+                                   int fd = socket.release();
+                                   boost::asio::post(worker.io_context, [&worker, fd]()
+                                                     { adopt_telemetry_session(worker, fd, std::string(), false); }); });
     }
     catch (std::exception &e)
     {
@@ -68,17 +518,31 @@ void start_telemetry_server(unsigned short port)
 }
 
 // Function to send commands to a specific drone
-void send_commands(boost::asio::io_context &io_context, const std::string &drone_ip, unsigned short port, const std::string &command)
+void send_commands(boost::asio::io_context &io_context, const std::string &drone_ip, unsigned short port, const cc::Command &command, int drone_id)
 {
     try
     {
-        boost::asio::ip::udp::socket socket(io_context);
-        boost::asio::ip::udp::endpoint endpoint(boost::asio::ip::make_address(drone_ip), port);
+        udp::endpoint endpoint(boost::asio::ip::make_address(drone_ip), port);
+        CommandChannel channel(cc::UdpDatagram(udp::socket(io_context, udp::v4()), endpoint));
+
+        uint64_t sent_ns = cc::monotonic_ns();
+        boost::system::error_code error;
+        channel.send(command, error);
+        if (error)
+            throw boost::system::system_error(error);
+        // Only commands that left can be echoed back, so a failed send opens no trace
+        tracer.command_sent(command.id, drone_id, sent_ns);
+        analytics->record_command(drone_id, sent_ns);
+        const std::string &wire = channel.sent();
 
-        socket.open(boost::asio::ip::udp::v4());
-        socket.send_to(boost::asio::buffer(command), endpoint);
-        socket.close();
-        std::cout << "Sent command: " << command << " to " << drone_ip << " on port " << port << std::endl;
+        // Each command is its own short-lived stream, matching how it goes out on the wire
+        if (recorder.is_open())
+        {
+            uint32_t session = recorder.open_session(cc::CaptureChannel::Command, port);
+            recorder.data(session, cc::CaptureChannel::Command, port, wire.data(), wire.size());
+            recorder.close_session(session, cc::CaptureChannel::Command, port);
+        }
+        std::cout << "Sent command: " << cc::format_command(command) << " to " << drone_ip << " on port " << port << std::endl;
     }
     catch (std::exception &e)
     {
@@ -86,128 +550,778 @@ void send_commands(boost::asio::io_context &io_context, const std::string &drone
     }
 }
 
-void manual_command_input(boost::asio::io_context &io_context, const std::string &drone_ip1, unsigned short port1, const std::string &drone_ip2, unsigned short port2)
+void print_positions(const std::vector<cc::DronePosition> &drones, std::chrono::steady_clock::time_point started)
+{
+    double elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+    for (const auto &drone : drones)
+        std::cout << "  Drone " << drone.drone_id << " at (" << drone.x << ", " << drone.y << ")" << std::endl;
+    std::cout << drones.size() << " drone(s) [" << elapsed_us << " us]" << std::endl;
+}
+
+// Fleet queries typed at the command prompt:
+//   near <drone> <radius>   drones within radius of a drone
+//   box <x0> <y0> <x1> <y1> drones inside a box
+//   knn <drone> <k>         k nearest drones to a drone
+//   conflicts <distance>    pairs of drones closer than distance
+// Returns false if the input is not a query.
+bool handle_fleet_query(const std::string &input)
+{
+    std::istringstream iss(input);
+    std::string verb;
+    iss >> verb;
+    if (verb != "near" && verb != "box" && verb != "knn" && verb != "conflicts")
+        return false;
+
+    auto started = std::chrono::steady_clock::now();
+    if (verb == "box")
+    {
+        double x0, y0, x1, y1;
+        if (!(iss >> x0 >> y0 >> x1 >> y1))
+            std::cout << "Usage: box <x0> <y0> <x1> <y1>" << std::endl;
+        else
+            print_positions(fleet_index.within_box(std::min(x0, x1), std::min(y0, y1), std::max(x0, x1), std::max(y0, y1)), started);
+        return true;
+    }
+    if (verb == "conflicts")
+    {
+        double distance;
+        if (!(iss >> distance))
+        {
+            std::cout << "Usage: conflicts <distance>" << std::endl;
+            return true;
+        }
+        cc::ConflictScan scan = fleet_index.conflicts(distance, 1000);
+        double elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+        for (const auto &pair : scan.pairs)
+            std::cout << "  Drones " << pair.first << " and " << pair.second << " are " << pair.distance << " apart" << std::endl;
+        std::cout << scan.pairs.size() << (scan.truncated ? "+" : "") << " conflict(s) [" << elapsed_us << " us]" << std::endl;
+        return true;
+    }
+
+    int drone_id;
+    double amount;
+    cc::DronePosition subject;
+    if (!(iss >> drone_id >> amount))
+    {
+        std::cout << "Usage: " << verb << (verb == "near" ? " <drone> <radius>" : " <drone> <k>") << std::endl;
+        return true;
+    }
+    if (!fleet_index.position_of(drone_id, subject))
+    {
+        std::cout << "No position known for drone " << drone_id << std::endl;
+        return true;
+    }
+
+    std::vector<cc::DronePosition> result;
+    if (verb == "near")
+    {
+        for (const auto &drone : fleet_index.within_radius(subject.x, subject.y, amount))
+        {
+            if (drone.drone_id != drone_id)
+                result.push_back(drone);
+        }
+    }
+    else
+    {
+        result = fleet_index.nearest(subject.x, subject.y, static_cast<size_t>(std::max(0.0, amount)), drone_id);
+    }
+    print_positions(result, started);
+    return true;
+}
+
+// "metrics" prints the fleet rollup, "metrics <drone>" one drone's live metrics
+void print_metrics(const std::string &input)
+{
+    uint64_t now = cc::monotonic_ns();
+    std::istringstream iss(input.substr(7));
+    int drone_id;
+    if (!(iss >> drone_id))
+    {
+        cc::FleetRollup fleet = analytics->rollup(now, stale_after_ns);
+        std::cout << fleet.drones << " drone(s), " << fleet.stale << " stale, " << fleet.moving << " moving; average speed "
+                  << fleet.average_speed << ", max speed " << fleet.max_speed << ", total distance " << fleet.total_distance
+                  << ", " << fleet.telemetry_rate << " samples/s" << std::endl;
+        return;
+    }
+
+    cc::DroneMetrics metrics;
+    if (!analytics->metrics_of(drone_id, now, metrics))
+    {
+        std::cout << "No telemetry from drone " << drone_id << std::endl;
+        return;
+    }
+    std::cout << "Drone " << drone_id << " at (" << metrics.x << ", " << metrics.y << "): speed " << metrics.speed
+              << " (window " << metrics.window_speed << "), distance " << metrics.distance << ", " << metrics.samples
+              << " samples, " << metrics.telemetry_rate << " samples/s, interval " << metrics.interval << " s, jitter "
+              << metrics.jitter << " s, last telemetry " << metrics.since_telemetry << " s ago, last command ";
+    if (metrics.since_command < 0)
+        std::cout << "never" << std::endl;
+    else
+        std::cout << metrics.since_command << " s ago" << std::endl;
+}
+
+// "loss" prints fleet-wide sequence accounting, "loss <drone>" one drone's
+void print_loss(const std::string &input)
+{
+    std::istringstream iss(input.substr(4));
+    int drone_id;
+    cc::SequenceStats stats;
+    if (iss >> drone_id)
+    {
+        if (!sequences.stats_of(drone_id, stats))
+        {
+            std::cout << "No numbered telemetry from drone " << drone_id << std::endl;
+            return;
+        }
+        std::cout << "Drone " << drone_id << ": highest seq " << stats.highest << ", ";
+    }
+    else
+    {
+        stats = sequences.totals();
+        size_t datagrams = 0;
+        for (const auto &worker : workers)
+            datagrams += worker->datagrams_received.load();
+        std::cout << sequences.size() << " drone(s), " << datagrams << " datagrams: ";
+    }
+    std::cout << stats.received << " of " << stats.expected << " samples received, " << stats.lost << " lost ("
+              << stats.loss_rate() * 100.0 << "%), " << stats.gaps << " gaps, " << stats.reordered << " reordered, "
+              << stats.duplicates << " duplicates, " << stats.stale << " stale, " << stats.restarts << " restarts" << std::endl;
+}
+
+// Raises an alert when a pair of drones first comes closer than the conflict distance
+// and again when it separates, rather than on every pass. At most max_conflict_alerts
+// pairs are printed per pass; the rest are summarised in one line. The scan itself is
+// capped (see SpatialIndex::conflicts), so the set of active pairs stays bounded; while
+// it is truncated, pairs missing from the pass may still be in conflict and are not
+// reported as cleared.
+const size_t max_conflict_alerts = 20;
+
+void report_conflicts(const cc::ConflictScan &scan)
+{
+    static std::set<std::pair<int, int>> active;
+    std::set<std::pair<int, int>> current;
+    size_t raised = 0, cleared = 0;
+    for (const auto &pair : scan.pairs)
+    {
+        current.insert(std::make_pair(pair.first, pair.second));
+        if (active.count(std::make_pair(pair.first, pair.second)))
+            continue;
+        if (++raised <= max_conflict_alerts)
+            std::cerr << "CONFLICT ALERT: drones " << pair.first << " and " << pair.second << " are " << pair.distance << " apart" << std::endl;
+    }
+    if (!scan.truncated)
+    {
+        for (const auto &pair : active)
+        {
+            if (current.count(pair))
+                continue;
+            if (++cleared <= max_conflict_alerts)
+                std::cout << "Conflict cleared: drones " << pair.first << " and " << pair.second << std::endl;
+        }
+    }
+    if (raised > max_conflict_alerts || cleared > max_conflict_alerts || (scan.truncated && raised > 0))
+    {
+        std::cerr << "CONFLICT ALERT: " << raised << " new and " << cleared << " cleared pair(s) this pass, " << scan.pairs.size()
+                  << (scan.truncated ? "+ (scan capped)" : "") << " in conflict" << std::endl;
+    }
+    active = std::move(current);
+}
+
+// History times are epoch seconds, "now" or "now-<seconds>"
+bool parse_history_time(const std::string &text, int64_t &ns)
+{
+    int64_t now = history.wall_ns(cc::monotonic_ns());
+    if (text == "now")
+    {
+        ns = now;
+        return true;
+    }
+    bool relative = text.compare(0, 4, "now-") == 0;
+    const char *start = text.c_str() + (relative ? 4 : 0);
+    char *end = nullptr;
+    double seconds = std::strtod(start, &end);
+    if (end == start || *end != '\0')
+        return false;
+    ns = relative ? now - static_cast<int64_t>(seconds * 1e9) : static_cast<int64_t>(seconds * 1e9);
+    return true;
+}
+
+// History queries, typed at the command prompt or sent to the query port:
+//   track <drone> <from> <to> [step]   one drone's positions, at most one per step seconds
+//   at <time> [tolerance]              every drone's last position at or before time,
+//                                      no older than tolerance seconds (default 1)
+// The reply is a count line and then one row per point; times are epoch seconds.
+// Returns false if the input is not a history query.
+bool answer_history_query(const std::string &input, std::ostream &out)
+{
+    std::istringstream iss(input);
+    std::string verb;
+    iss >> verb;
+    if (verb != "track" && verb != "at")
+        return false;
+    if (!history.is_open())
+    {
+        out << "ERR history is off (start the server with --history <dir>)" << std::endl;
+        return true;
+    }
+
+    out << std::fixed << std::setprecision(3);
+    if (verb == "track")
+    {
+        int drone_id;
+        std::string from_text, to_text;
+        double step = 0.0;
+        int64_t from, to;
+        if (!(iss >> drone_id >> from_text >> to_text) || !parse_history_time(from_text, from) || !parse_history_time(to_text, to))
+        {
+            out << "ERR usage: track <drone> <from> <to> [step]" << std::endl;
+            return true;
+        }
+        iss >> step;
+        int level;
+        std::vector<cc::HistoryRecord> points = history.track(drone_id, from, to, static_cast<int64_t>(std::max(0.0, step) * 1e9), level);
+        out << points.size() << " point(s) for drone " << drone_id << " from the " << cc::history_level_names[level] << " level" << std::endl;
+        for (const auto &point : points)
+            out << point.start_ns * 1e-9 << " " << point.x << " " << point.y << " " << point.altitude << " " << point.count << std::endl;
+        return true;
+    }
+
+    std::string at_text;
+    double tolerance = 1.0;
+    int64_t at;
+    if (!(iss >> at_text) || !parse_history_time(at_text, at))
+    {
+        out << "ERR usage: at <time> [tolerance]" << std::endl;
+        return true;
+    }
+    iss >> tolerance;
+    std::vector<cc::HistoryPosition> positions = history.fleet_at(at, static_cast<int64_t>(std::max(0.0, tolerance) * 1e9));
+    out << positions.size() << " drone(s) at " << at * 1e-9 << std::endl;
+    for (const auto &position : positions)
+        out << position.drone_id << " " << position.record.last_ns * 1e-9 << " " << position.record.last_x << " " << position.record.last_y
+            << " " << position.record.last_altitude << " " << cc::history_level_names[position.level] << std::endl;
+    return true;
+}
+
+void print_drones()
+{
+    std::vector<cc::DroneAddress> drones = registry.list();
+    for (const auto &drone : drones)
+        std::cout << "  Drone " << drone.drone_id << " at " << drone.address << ", control port " << drone.control_port << std::endl;
+    std::cout << drones.size() << " drone(s) registered" << std::endl;
+}
+
+void manual_command_input()
 {
     while (true)
     {
         std::string input;
-        std::cout << "Enter command (e.g., '1 move back' or '2 move left'): ";
-        std::getline(std::cin, input);
+        std::cout << "Enter command (e.g., '1 move back', '2 move left 5' or '1 goto 10 20 30'): ";
+        if (!std::getline(std::cin, input))
+            break; // Operator input closed
+
+        if (input == "drones")
+        {
+            print_drones();
+            continue;
+        }
+
+        if (input == "workers")
+        {
+            for (const auto &worker : workers)
+            {
+                std::cout << "worker " << worker->id << ": " << worker->telemetry_sessions.load() << " telemetry sessions, "
+                          << worker->file_sessions.load() << " file transfers, " << worker->handed_over.load() << " connections handed over, "
+                          << worker->sessions.reserved_bytes() / 1024 << " KiB session slabs" << std::endl;
+            }
+            std::cout << "session object " << cc::SlabPool<TelemetrySession>::slot_size() << " bytes; io buffers: " << io_buffers->lent()
+                      << " lent (peak " << io_buffers->peak_lent() << "), " << io_buffers->cached() << " cached, "
+                      << io_buffers->buffer_size() << " bytes each" << std::endl;
+            continue;
+        }
+
+        if (handle_fleet_query(input))
+            continue;
+
+        if (answer_history_query(input, std::cout))
+            continue;
+
+        if (input.compare(0, 7, "metrics") == 0)
+        {
+            print_metrics(input);
+            continue;
+        }
+
+        if (input == "loss" || input.compare(0, 5, "loss ") == 0)
+        {
+            print_loss(input);
+            continue;
+        }
+
+        if (input == "uploads")
+        {
+            cc::UploadStats stats = uploads.stats(cc::monotonic_ns());
+            std::cout << stats.active << " of " << stats.slots << " upload slot(s) busy, " << stats.waiting << " drone(s) waiting ("
+                      << stats.standby << " on standby); ingest "
+                      << stats.ingest_rate / 1e6 << " MB/s (smoothed " << stats.throughput / 1e6 << "), disk busy " << stats.disk_busy * 100.0 << "%, best per-upload rate "
+                      << stats.upload_rate / 1e6 << " MB/s, typical upload " << stats.upload_seconds << " s; " << stats.granted
+                      << " granted, " << stats.deferred << " deferred, " << stats.completed << " completed" << std::endl;
+            continue;
+        }
+
+        if (input == "trace")
+        {
+            tracer.print_summary();
+            continue;
+        }
+        if (input.compare(0, 13, "trace export ") == 0)
+        {
+            std::string path = input.substr(13);
+            if (tracer.export_csv(path))
+                std::cout << "Exported command traces to " << path << " and histograms to " << path << ".hist" << std::endl;
+            else
+                std::cout << "Failed to write " << path << std::endl;
+            continue;
+        }
+
+        if (input == "stats")
+        {
+            cc::print_stage_stats({decode_stage->stats(), state_stage->stats(), sink_stage->stats()});
+            continue;
+        }
 
         // Parse the command input
-        int drone_id;
-        std::string command;
+        int drone_id = 0;
+        std::string text;
         std::istringstream iss(input);
         iss >> drone_id;
-        std::getline(iss, command);
-        command = command.substr(1); // Remove leading space
+        std::getline(iss, text);
 
-        if (drone_id == 1)
+        cc::Command command;
+        std::string parse_error;
+        if (!cc::parse_command(text, command, &parse_error))
         {
-            send_commands(io_context, drone_ip1, port1, command);
+            std::cout << "Invalid command (" << parse_error << "). Commands: " << cc::command_usage() << std::endl;
+            continue;
         }
-        else if (drone_id == 2)
-        {
-            send_commands(io_context, drone_ip2, port2, command);
-        }
-        else
+
+        cc::DroneAddress drone;
+        if (!registry.lookup(drone_id, drone))
         {
-            std::cout << "Invalid drone ID. Use 1 or 2." << std::endl;
+            std::cout << "Unknown drone " << drone_id << ". Type 'drones' to list registered drones." << std::endl;
+            continue;
         }
+
+        // Commands are sent from the worker that owns the drone
+        command.id = tracer.next_id();
+        Worker &owner = owner_of(drone_id);
+        std::string drone_ip = drone.address;
+        unsigned short port = drone.control_port;
+        boost::asio::post(owner.io_context, [&owner, drone_ip, port, command, drone_id]()
+                          { send_commands(owner.io_context, drone_ip, port, command, drone_id); });
     }
 }
 
-// Function to handle incoming file transfer from a drone
-void handle_file_transfer(tcp::socket socket, const std::string &filename)
+// Function to handle incoming file transfer from a drone. A new connection first reads
+// the "Drone <id>" header (see cc_registration.hpp). A header that also gives the size
+// asks for an upload slot (see cc_upload.hpp) and is answered GO or WAIT here, before
+// anything else. The connection then moves to the drone's worker if it landed
+// elsewhere; a handed-over one arrives with drone_id and any bytes read past the header.
+void handle_file_transfer(tcp::socket socket, int worker_id, int drone_id, std::string pending)
 {
+    if (drone_id < 0)
+    {
+        std::string header;
+        if (!cc::read_line(socket, header, pending, 30000) || !cc::parse_file_header(header, drone_id))
+        {
+            std::cerr << "[worker " << worker_id << "] File transfer without a valid drone header, closing" << std::endl;
+            return;
+        }
+
+        uint64_t bytes;
+        cc::UploadPriority priority;
+        if (cc::parse_upload_request(header, bytes, priority))
+        {
+            cc::UploadDecision decision = uploads.request(drone_id, bytes, priority, cc::monotonic_ns());
+            if (decision.standby)
+            {
+                // Next in line: hold the connection until a slot frees (drones wait 30 s for an answer)
+                decision.go = uploads.await_slot(drone_id, upload_standby_ms);
+                decision.wait_ms = 0;
+            }
+            std::string reply = decision.go ? std::string("GO\n") : "WAIT " + std::to_string(decision.wait_ms) + "\n";
+            boost::system::error_code error;
+            boost::asio::write(socket, boost::asio::buffer(reply), error);
+            if (!decision.go)
+                return;
+            if (error)
+            {
+                uploads.finished(drone_id, cc::monotonic_ns());
+                return;
+            }
+        }
+
+        Worker &owner = owner_of(drone_id);
+        if (owner.id != worker_id)
+        {
+            workers[worker_id]->handed_over++;
+            hand_over(owner, Handoff{Handoff::File, socket.release(), std::move(pending), drone_id});
+            return;
+        }
+    }
+
+    workers[worker_id]->file_sessions++;
+    unsigned short port = socket.local_endpoint().port();
+    FileChannel transfer(std::move(socket));
+    std::string filename = "drone" + std::to_string(drone_id) + "_file.txt";
+    uint32_t session = recorder.open_session(cc::CaptureChannel::File, port);
     try
     {
         std::ofstream outfile(filename, std::ios::binary | std::ios::trunc);
         if (!outfile)
         {
             std::cerr << "Failed to open file: " << filename << std::endl;
+            recorder.close_session(session, cc::CaptureChannel::File, port);
+            uploads.finished(drone_id, cc::monotonic_ns());
+            workers[worker_id]->file_sessions--;
             return;
         }
 
-        char data[1024];
+        // The capture keeps the header so a replayed transfer is routed the same way
+        if (recorder.is_open())
+        {
+            std::string header = cc::format_file_header(drone_id);
+            recorder.data(session, cc::CaptureChannel::File, port, header.data(), header.size());
+            recorder.data(session, cc::CaptureChannel::File, port, pending.data(), pending.size());
+        }
+        outfile.write(pending.data(), pending.size());
+
+        cc::PooledBuffer buffer = io_buffers->acquire();
+        char *data = buffer.data();
         boost::system::error_code error;
 
         while (true)
         {
-            size_t len = socket.read_some(boost::asio::buffer(data), error);
+            size_t len = transfer.receive_into(data, buffer.size(), error);
 
             if (error == boost::asio::error::eof)
                 break; // Connection closed cleanly by peer
             else if (error)
                 throw boost::system::system_error(error); // Handle other errors
 
+            recorder.data(session, cc::CaptureChannel::File, port, data, len);
+            uint64_t write_start = cc::monotonic_ns();
             outfile.write(data, len);
+            uint64_t write_end = cc::monotonic_ns();
+            uploads.progress(len, write_end - write_start, write_end);
         }
 
-        std::cout << "File transfer completed: " << filename << std::endl;
+        std::cout << "[worker " << worker_id << "] File transfer completed: " << filename << std::endl;
     }
     catch (std::exception &e)
     {
         std::cerr << "Exception in file transfer handler: " << e.what() << std::endl;
     }
+    recorder.close_session(session, cc::CaptureChannel::File, port);
+    uploads.finished(drone_id, cc::monotonic_ns());
+    workers[worker_id]->file_sessions--;
+}
+
+// One file port for the whole fleet; the transfer's header names the drone
+void start_file_transfer_server(unsigned short port, int worker_id)
+{
+    try
+    {
+        boost::asio::io_context io_context;
+        tcp::acceptor acceptor = open_acceptor(io_context, port, workers.size() > 1);
+        std::cout << "[worker " << worker_id << "] File transfer server listening on port " << port << std::endl;
+
+        cc::run_batched_accept(acceptor, admission, [worker_id](tcp::socket socket)
+                               {
+                                   std::cout << "[worker " << worker_id << "] New file transfer client connected!" << std::endl;
+                                   std::thread(handle_file_transfer, std::move(socket), worker_id, -1, std::string()).detach(); });
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Exception in file transfer server: " << e.what() << std::endl;
+    }
+}
+
+// Whether a drone has sent telemetry within stale_after, i.e. its session is not gone
+bool drone_live(int drone_id)
+{
+    cc::DroneMetrics metrics;
+    return drone_id != 0 && analytics->metrics_of(drone_id, cc::monotonic_ns(), metrics) &&
+           metrics.since_telemetry * 1e9 < static_cast<double>(stale_after_ns);
+}
+
+// Answers one registration request (see cc_registration.hpp). Runs on the accept
+// thread; read_line bounds how long a silent client can hold it.
+void handle_registration(tcp::socket &socket, const cc::Registration &ports)
+{
+    std::string line, rest, reply;
+    int requested_id = 0;
+    unsigned short requested_port = 0;
+    if (!cc::read_line(socket, line, rest, 500) || !cc::parse_register_request(line, requested_id, requested_port))
+    {
+        reply = "REJECT malformed registration\n";
+    }
+    else
+    {
+        boost::system::error_code error;
+        tcp::endpoint peer = socket.remote_endpoint(error);
+        cc::DroneAddress drone;
+        std::string enroll_error;
+        if (error)
+        {
+            reply = "REJECT " + error.message() + "\n";
+        }
+        else if (!registry.enroll(requested_id, requested_port, peer.address().to_string(), drone_live(requested_id), drone, &enroll_error))
+        {
+            reply = "REJECT " + enroll_error + "\n";
+            std::cerr << "Registration from " << peer.address().to_string() << " refused: " << enroll_error << std::endl;
+        }
+        else
+        {
+            cc::Registration registration = ports;
+            registration.drone_id = drone.drone_id;
+            registration.control_port = drone.control_port;
+            reply = cc::format_welcome(registration);
+            std::cout << "Registered drone " << drone.drone_id << " at " << drone.address << ", control port " << drone.control_port << std::endl;
+        }
+    }
+    boost::system::error_code ignored;
+    boost::asio::write(socket, boost::asio::buffer(reply), ignored);
 }
 
-// Function to start a file transfer server for each drone
-void start_file_transfer_server(unsigned short port, const std::string &filename)
+void start_registration_server(unsigned short port, cc::Registration ports)
 {
     try
     {
         boost::asio::io_context io_context;
-        tcp::acceptor acceptor(io_context, tcp::endpoint(tcp::v4(), port));
-        std::cout << "File transfer server listening on port " << port << std::endl;
+        tcp::acceptor acceptor = open_acceptor(io_context, port, false);
+        std::cout << "Registration server listening on port " << port << std::endl;
+        cc::run_batched_accept(acceptor, admission, [&ports](tcp::socket socket)
+                               { handle_registration(socket, ports); });
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Exception in registration server: " << e.what() << std::endl;
+    }
+}
 
+// Answers history queries, one per line, until the client disconnects
+void serve_history_queries(tcp::socket socket)
+{
+    try
+    {
+        boost::asio::streambuf buffer;
         while (true)
         {
-            tcp::socket socket(io_context);
-            acceptor.accept(socket);
-            std::cout << "New file transfer client connected!" << std::endl;
-            std::thread(handle_file_transfer, std::move(socket), filename).detach();
+            boost::asio::read_until(socket, buffer, '\n');
+            std::istream stream(&buffer);
+            std::string line;
+            std::getline(stream, line);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            std::ostringstream reply;
+            if (!answer_history_query(line, reply))
+                reply << "ERR unknown query (use track or at)" << std::endl;
+            boost::asio::write(socket, boost::asio::buffer(reply.str()));
         }
     }
+    catch (std::exception &)
+    {
+        // Client went away
+    }
+}
+
+void start_query_server(unsigned short port)
+{
+    try
+    {
+        boost::asio::io_context io_context;
+        tcp::acceptor acceptor = open_acceptor(io_context, port, false);
+        std::cout << "History query server listening on port " << port << std::endl;
+        cc::run_batched_accept(acceptor, admission, [](tcp::socket socket)
+                               { std::thread(serve_history_queries, std::move(socket)).detach(); });
+    }
     catch (std::exception &e)
     {
-        std::cerr << "Exception in file transfer server: " << e.what() << std::endl;
+        std::cerr << "Exception in query server: " << e.what() << std::endl;
     }
 }
 
-int main()
+// Adopts a connection handed over by another worker; runs on the owner's io_context
+void adopt_handoff(Worker &worker, Handoff handoff)
 {
-    unsigned short command_port_1 = 9000;       // Port to send commands to drone 1
-    unsigned short command_port_2 = 9002;       // Port to send commands to drone 2
-    unsigned short telemetry_port = 9001;       // Port to receive telemetry data
-    unsigned short file_transfer_port_1 = 9003; // File transfer port for drone 1
-    unsigned short file_transfer_port_2 = 9004; // File transfer port for drone 2
+    if (handoff.kind == Handoff::Telemetry)
+    {
+        adopt_telemetry_session(worker, handoff.fd, std::move(handoff.pending), true);
+        return;
+    }
 
-    // Starting the telemetry server in a separate thread
-    std::thread telemetry_thread(start_telemetry_server, telemetry_port);
+    try
+    {
+        tcp::socket socket(worker.io_context);
+        socket.assign(tcp::v4(), handoff.fd);
+        std::thread(handle_file_transfer, std::move(socket), worker.id, handoff.drone_id, std::move(handoff.pending)).detach();
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "[worker " << worker.id << "] Failed to adopt handed-over connection: " << e.what() << std::endl;
+        ::close(handoff.fd);
+        uploads.finished(handoff.drone_id, cc::monotonic_ns());
+    }
+}
 
-    // Setting up command sending for each drone in separate threads
-    boost::asio::io_context io_context;
-    std::string drone_ip1 = "127.0.0.1"; // Replace with actual drone IP
-    std::string drone_ip2 = "127.0.0.1"; // Replace with second drone IP if different
+// Server settings come from --config <file> and the command line (see cc_config.hpp):
+//   workers, queue_depth, backpressure, pin_stages, io_buffer_size, io_buffers,
+//   telemetry_port, file_port, registration_port, control_port_base, max_drones,
+//   record, conflict_distance, max_conflicts, metrics_window, stale_after, listen_backlog,
+//   admit_rate, admit_burst, history, history_flush, query_port, query_threads,
+//   upload_slots, upload_min_slots, upload_max_slots, ingest_capacity, disk_busy,
+//   trace_timeout, trace_keep, and
+//   drone.<id> = <ip>:<control port> for drones that do not register.
+int main(int argc, char *argv[])
+{
+    cc::Config config;
+    std::string config_error;
+    if (!config.load(argc, argv, &config_error))
+    {
+        std::cerr << config_error << std::endl;
+        return 1;
+    }
 
-    // Start manual command input thread for sending commands to drones
-    std::thread command_input_thread(manual_command_input, std::ref(io_context), drone_ip1, command_port_1, drone_ip2, command_port_2);
+    size_t worker_count = static_cast<size_t>(std::max(1L, config.get_int("workers", 1)));
+    double conflict_distance = config.get_double("conflict_distance", 5.0); // Alert when two drones are closer than this
+    double metrics_window_s = std::max(1.0, config.get_double("metrics_window", 600.0)); // Span of the sliding-window metrics
+    stale_after_ns = static_cast<uint64_t>(std::max(0.0, config.get_double("stale_after", 600.0)) * 1e9);
+    tracer.configure(static_cast<uint64_t>(std::max(0.0, config.get_double("trace_timeout", 60.0)) * 1e9), // Seconds before an unanswered command counts as lost
+                     static_cast<size_t>(std::max(1L, config.get_int("trace_keep", 100000))));             // Completed traces kept for trace export
+    admission.listen_backlog = static_cast<int>(std::max(1L, config.get_int("listen_backlog", admission.listen_backlog)));
+    admission.admit_rate = config.get_double("admit_rate", admission.admit_rate);
+    admission.admit_burst = config.get_double("admit_burst", admission.admit_burst);
 
-    // Start file transfer servers for each drone
-    std::thread file_transfer_thread_1(start_file_transfer_server, file_transfer_port_1, "drone1_file.txt");
-    std::thread file_transfer_thread_2(start_file_transfer_server, file_transfer_port_2, "drone2_file.txt");
+    cc::StageOptions stage_options;
+    stage_options.capacity = static_cast<size_t>(std::max(2L, config.get_int("queue_depth", static_cast<long>(stage_options.capacity))));
+    if (config.has("backpressure") && !cc::parse_backpressure(config.get("backpressure"), stage_options.policy))
+    {
+        std::cerr << "Unknown backpressure policy (use block, drop-oldest or sample): " << config.get("backpressure") << std::endl;
+        return 1;
+    }
+
+    // Comma-separated cores for the decode, state and sink stages, e.g. 1,2,3 (-1 = unpinned)
+    std::vector<int> stage_cores;
+    std::istringstream cores(config.get("pin_stages"));
+    std::string core;
+    while (std::getline(cores, core, ','))
+        stage_cores.push_back(std::atoi(core.c_str()));
 
-    // Running the io_context to handle asynchronous operations
-    std::thread io_context_thread([&io_context]()
-                                  { io_context.run(); });
+    if (config.has("record"))
+    {
+        std::string capture_path = config.get("record");
+        if (!recorder.open(capture_path))
+        {
+            std::cerr << "Failed to open capture file: " << capture_path << std::endl;
+            return 1;
+        }
+        std::cout << "Recording all channels to " << capture_path << std::endl;
+    }
+
+    cc::UploadOptions upload_options;
+    upload_options.initial_slots = static_cast<size_t>(std::max(1L, config.get_int("upload_slots", static_cast<long>(upload_options.initial_slots))));
+    upload_options.min_slots = static_cast<size_t>(std::max(1L, config.get_int("upload_min_slots", static_cast<long>(upload_options.min_slots))));
+    upload_options.max_slots = static_cast<size_t>(std::max(1L, config.get_int("upload_max_slots", static_cast<long>(upload_options.max_slots))));
+    upload_options.capacity = std::max(0.0, config.get_double("ingest_capacity", 0.0)) * 1e6; // MB/s
+    upload_options.disk_busy = config.get_double("disk_busy", upload_options.disk_busy);
+    uploads.configure(upload_options);
+
+    if (config.has("history"))
+    {
+        cc::HistoryOptions history_options;
+        history_options.flush_interval_ns = static_cast<int64_t>(std::max(0.0, config.get_double("history_flush", 1.0)) * 1e9);
+        history_options.query_threads = static_cast<size_t>(std::max(0L, config.get_int("query_threads", 0)));
+        std::string history_error;
+        if (!history.open(config.get("history"), history_options, &history_error))
+        {
+            std::cerr << "Failed to open telemetry history: " << history_error << std::endl;
+            return 1;
+        }
+        std::cout << "Keeping telemetry history in " << config.get("history") << " (" << history.drones() << " drone(s) on record)" << std::endl;
+    }
+
+    io_buffers.reset(new cc::BufferPool(static_cast<size_t>(std::max(512L, config.get_int("io_buffer_size", 4096))),
+                                        static_cast<size_t>(std::max(0L, config.get_int("io_buffers", 1024)))));
+
+    unsigned short telemetry_port = static_cast<unsigned short>(config.get_int("telemetry_port", 9001));          // Telemetry from every drone (TCP and UDP)
+    unsigned short file_transfer_port = static_cast<unsigned short>(config.get_int("file_port", 9003));          // File transfers from every drone
+    unsigned short registration_port = static_cast<unsigned short>(config.get_int("registration_port", 8999));   // Drones register here at startup
+    registry.configure(static_cast<unsigned>(config.get_int("control_port_base", 10000)), static_cast<size_t>(config.get_int("max_drones", 65536)));
+
+    // Drones with fixed addresses, e.g. "drone.1 = 127.0.0.1:9000"
+    for (const auto &entry : config.with_prefix("drone."))
+    {
+        int drone_id = std::atoi(entry.first.c_str() + 6);
+        size_t colon = entry.second.rfind(':');
+        if (drone_id <= 0 || colon == std::string::npos)
+        {
+            std::cerr << "Ignoring malformed drone entry: " << entry.first << " = " << entry.second << std::endl;
+            continue;
+        }
+        registry.add(cc::DroneAddress{drone_id, entry.second.substr(0, colon), static_cast<unsigned short>(std::atoi(entry.second.c_str() + colon + 1))});
+    }
+
+    for (size_t i = 0; i < worker_count; ++i)
+    {
+        workers.emplace_back(new Worker());
+        workers.back()->id = static_cast<int>(i);
+    }
+    if (worker_count > 1)
+        std::cout << "Starting " << worker_count << " workers sharing each port via SO_REUSEPORT" << std::endl;
+
+    analytics.reset(new cc::DroneAnalytics(static_cast<uint64_t>(metrics_window_s * 1e9)));
+    start_ingest_pipeline(stage_options, stage_cores);
+
+    // Continuous conflict detection runs once a second off the ingest path; drones silent
+    // for stale_after leave the index
+    fleet_index.start(conflict_distance, std::chrono::milliseconds(1000), report_conflicts, std::chrono::nanoseconds(stale_after_ns),
+                      static_cast<size_t>(std::max(1L, config.get_int("max_conflicts", 10000))));
+
+    std::vector<std::thread> threads;
+    std::vector<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> work_guards;
+    for (size_t i = 0; i < worker_count; ++i)
+    {
+        int worker_id = static_cast<int>(i);
+        Worker &worker = *workers[i];
+        work_guards.push_back(boost::asio::make_work_guard(worker.io_context));
+        start_datagram_telemetry(worker, telemetry_port);
+
+        // Every worker accepts on every port; the kernel load-balances between them
+        threads.emplace_back(start_telemetry_server, telemetry_port, worker_id);
+        threads.emplace_back(start_file_transfer_server, file_transfer_port, worker_id);
+
+        // The worker's io_context runs its telemetry sessions, adopts handoffs and sends commands
+        threads.emplace_back([&worker]()
+                             { worker.io_context.run(); });
+    }
+
+    // Drones learn their id and ports here; telemetry and files go to the shared ports
+    cc::Registration ports;
+    ports.telemetry_port = telemetry_port;
+    ports.file_port = file_transfer_port;
+    threads.emplace_back(start_registration_server, registration_port, ports);
+
+    if (history.is_open())
+        threads.emplace_back(start_query_server, static_cast<unsigned short>(config.get_int("query_port", 9004)));
+
+    // Start manual command input thread for sending commands to drones
+    threads.emplace_back(manual_command_input);
 
     // Wait for all threads to complete
-    telemetry_thread.join();
-    command_input_thread.join();
-    file_transfer_thread_1.join();
-    file_transfer_thread_2.join();
-    io_context_thread.join();
+    for (auto &thread : threads)
+        thread.join();
 
+    stop_ingest_pipeline();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,326 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "cc_affinity.hpp"
+
+// Staged ingest pipeline: recv -> decode -> state update -> sinks.
+//
+// Stages are connected by bounded lock-free queues. Each stage has one consumer
+// thread (optionally pinned to a core); producers may be many socket threads.
+// When a queue is full the producer applies the stage's backpressure policy
+// instead of letting a slow consumer stall the socket indefinitely. An idle
+// consumer spins briefly and then parks until a producer wakes it.
+namespace cc
+{
+    enum class Backpressure
+    {
+        Block,      // Producer waits for space (lossless, may stall the socket)
+        DropOldest, // Evict the oldest queued item to make room (freshest data wins)
+        Sample      // Above half full, admit only one item in sample_every; drop when full
+    };
+
+    inline bool parse_backpressure(const std::string &text, Backpressure &policy)
+    {
+        if (text == "block")
+            policy = Backpressure::Block;
+        else if (text == "drop-oldest")
+            policy = Backpressure::DropOldest;
+        else if (text == "sample")
+            policy = Backpressure::Sample;
+        else
+            return false;
+        return true;
+    }
+
+    // Bounded multi-producer/multi-consumer ring (Vyukov). Used as MPSC for the ingest
+    // stage and SPSC between later stages; the consumer side is also touched by
+    // producers when they evict under DropOldest.
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+        explicit BoundedQueue(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity)
+                size <<= 1;
+            mask_ = size - 1;
+            cells_.reset(new Cell[size]);
+            for (size_t i = 0; i < size; ++i)
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        bool try_push(T &item)
+        {
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Cell &cell = cells_[pos & mask_];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+                if (diff == 0)
+                {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        cell.value = std::move(item);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                    return false; // Full
+                else
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        bool try_pop(T &item)
+        {
+            size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Cell &cell = cells_[pos & mask_];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+                if (diff == 0)
+                {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        item = std::move(cell.value);
+                        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                    return false; // Empty
+                else
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        size_t capacity() const { return mask_ + 1; }
+
+        size_t depth() const
+        {
+            size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+            size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> cells_;
+        size_t mask_ = 0;
+        alignas(64) std::atomic<size_t> enqueue_pos_{0};
+        alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    };
+
+    struct StageStats
+    {
+        std::string name;
+        size_t depth;
+        size_t capacity;
+        size_t high_water;
+        uint64_t accepted;
+        uint64_t processed;
+        uint64_t dropped;
+        double items_per_s; // Processed since the previous sample (or since start)
+    };
+
+    struct StageOptions
+    {
+        size_t capacity = 4096;
+        Backpressure policy = Backpressure::Block;
+        int core = -1; // -1 = unpinned
+        size_t sample_every = 4;
+    };
+
+    // One pipeline stage: an input queue plus the consumer thread that drains it
+    template <typename T>
+    class Stage
+    {
+    public:
+        Stage(std::string name, const StageOptions &options)
+            : name_(std::move(name)), options_(options), queue_(options.capacity) {}
+
+        ~Stage() { stop(); }
+
+        // handler(T &) runs on the stage thread for every item, in queue order
+        template <typename Handler>
+        void start(Handler handler)
+        {
+            running_.store(true);
+            last_sample_ = std::chrono::steady_clock::now();
+            thread_ = std::thread([this, handler]() mutable
+                                  {
+                                      pin_current_thread(options_.core, name_ + " stage");
+                                      T item;
+                                      unsigned idle = 0;
+                                      while (running_.load(std::memory_order_relaxed))
+                                      {
+                                          if (queue_.try_pop(item))
+                                          {
+                                              idle = 0;
+                                              handler(item);
+                                              processed_.fetch_add(1, std::memory_order_relaxed);
+                                              continue;
+                                          }
+                                          // Spin briefly, then park until a producer pushes
+                                          if (++idle < 64)
+                                              continue;
+                                          if (idle < 256)
+                                              std::this_thread::yield();
+                                          else
+                                              park();
+                                      }
+                                      // Drain what was queued before stop() so no accepted item is lost
+                                      while (queue_.try_pop(item))
+                                      {
+                                          handler(item);
+                                          processed_.fetch_add(1, std::memory_order_relaxed);
+                                      } });
+        }
+
+        // Processes everything already queued, then joins the stage thread. Stop stages
+        // in pipeline order so each drains into a downstream stage that is still running.
+        void stop()
+        {
+            if (!running_.exchange(false))
+                return;
+            {
+                std::lock_guard<std::mutex> lock(park_mutex_);
+                wake_.notify_one();
+            }
+            if (thread_.joinable())
+                thread_.join();
+        }
+
+        // Called by the upstream producer(s). Returns false if the item was dropped.
+        bool push(T item)
+        {
+            bool admitted = admit(item);
+            if (admitted)
+            {
+                wake_consumer();
+                accepted_.fetch_add(1, std::memory_order_relaxed);
+                size_t depth = queue_.depth();
+                size_t high = high_water_.load(std::memory_order_relaxed);
+                while (depth > high && !high_water_.compare_exchange_weak(high, depth, std::memory_order_relaxed))
+                {
+                }
+            }
+            else
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return admitted;
+        }
+
+        // Snapshot of the counters; items_per_s covers the time since the previous call
+        StageStats stats()
+        {
+            std::lock_guard<std::mutex> lock(sample_mutex_);
+            auto now = std::chrono::steady_clock::now();
+            uint64_t processed = processed_.load();
+            double seconds = std::chrono::duration<double>(now - last_sample_).count();
+            double rate = seconds > 0.0 ? (processed - last_processed_) / seconds : 0.0;
+            last_sample_ = now;
+            last_processed_ = processed;
+            return StageStats{name_, queue_.depth(), queue_.capacity(), high_water_.load(), accepted_.load(), processed, dropped_.load(), rate};
+        }
+
+    private:
+        // The consumer announces it is parked before its last look at the queue, and a
+        // producer checks the flag after publishing; the fences make one of them see the other.
+        void park()
+        {
+            std::unique_lock<std::mutex> lock(park_mutex_);
+            parked_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            wake_.wait(lock, [this]()
+                       { return queue_.depth() > 0 || !running_.load(std::memory_order_relaxed); });
+            parked_.store(false, std::memory_order_relaxed);
+        }
+
+        void wake_consumer()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!parked_.load(std::memory_order_relaxed))
+                return;
+            // Taking the lock orders this after the consumer's last check; notifying after
+            // releasing it lets the consumer run without blocking on the mutex again
+            {
+                std::lock_guard<std::mutex> lock(park_mutex_);
+            }
+            wake_.notify_one();
+        }
+
+        bool admit(T &item)
+        {
+            switch (options_.policy)
+            {
+            case Backpressure::Block:
+                while (!queue_.try_push(item))
+                    std::this_thread::yield();
+                return true;
+
+            case Backpressure::DropOldest:
+                while (!queue_.try_push(item))
+                {
+                    T victim;
+                    if (queue_.try_pop(victim))
+                        dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+                return true;
+
+            case Backpressure::Sample:
+                if (queue_.depth() * 2 >= queue_.capacity() &&
+                    sample_counter_.fetch_add(1, std::memory_order_relaxed) % options_.sample_every != 0)
+                    return false;
+                return queue_.try_push(item);
+            }
+            return false;
+        }
+
+        std::string name_;
+        StageOptions options_;
+        BoundedQueue<T> queue_;
+        std::thread thread_;
+        std::atomic<bool> running_{false};
+        std::atomic<bool> parked_{false};
+        std::mutex park_mutex_;
+        std::condition_variable wake_;
+        std::mutex sample_mutex_;
+        std::chrono::steady_clock::time_point last_sample_;
+        uint64_t last_processed_ = 0;
+        std::atomic<uint64_t> accepted_{0};
+        std::atomic<uint64_t> processed_{0};
+        std::atomic<uint64_t> dropped_{0};
+        std::atomic<size_t> high_water_{0};
+        std::atomic<uint64_t> sample_counter_{0};
+    };
+
+    // Prints one line per stage
+    inline void print_stage_stats(const std::vector<StageStats> &stages)
+    {
+        for (const StageStats &stage : stages)
+            std::cout << "stage " << stage.name << ": depth " << stage.depth << "/" << stage.capacity
+                      << " (high " << stage.high_water << "), in " << stage.accepted << ", out " << stage.processed
+                      << ", dropped " << stage.dropped << ", " << stage.items_per_s << " items/s" << std::endl;
+    }
+}
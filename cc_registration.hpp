@@ -0,0 +1,278 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <poll.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Drone registration: how a drone learns its identity and ports from the server.
+//
+// A drone opens a TCP connection to the server's registration port and sends one line
+//   REGISTER <drone id or 0> <control port or 0>
+// and the server answers with one line
+//   WELCOME <drone id> <control port> <telemetry port> <file port>
+// or "REJECT <reason>". A zero asks the server to choose: it hands out the next free
+// id, and control port control_port_base + id, so many drones can share a host. The
+// drone binds the control port it was given and the server remembers the address the
+// request came from, which is where commands for that drone go.
+//
+// File transfers open with a one-line header, "Drone <id>", that names the sender,
+// so every drone shares one file port.
+namespace cc
+{
+    struct Registration
+    {
+        int drone_id = 0;
+        unsigned short control_port = 0;
+        unsigned short telemetry_port = 0;
+        unsigned short file_port = 0;
+    };
+
+    // Where the server sends a drone's commands
+    struct DroneAddress
+    {
+        int drone_id = 0;
+        std::string address;
+        unsigned short control_port = 0;
+    };
+
+    inline std::string format_register_request(int drone_id, unsigned short control_port)
+    {
+        return "REGISTER " + std::to_string(drone_id) + " " + std::to_string(control_port) + "\n";
+    }
+
+    // Numbers that do not fit fail the stream rather than wrapping, unlike sscanf's %d
+    inline bool parse_register_request(const std::string &line, int &drone_id, unsigned short &control_port)
+    {
+        std::istringstream request(line);
+        std::string verb;
+        long long id = -1, port = -1;
+        if (!(request >> verb >> id >> port) || verb != "REGISTER" || id < 0 || id > INT_MAX || port < 0 || port > 65535)
+            return false;
+        drone_id = static_cast<int>(id);
+        control_port = static_cast<unsigned short>(port);
+        return true;
+    }
+
+    inline std::string format_welcome(const Registration &registration)
+    {
+        return "WELCOME " + std::to_string(registration.drone_id) + " " + std::to_string(registration.control_port) + " " +
+               std::to_string(registration.telemetry_port) + " " + std::to_string(registration.file_port) + "\n";
+    }
+
+    inline bool parse_welcome(const std::string &line, Registration &registration, std::string *error = nullptr)
+    {
+        unsigned control = 0, telemetry = 0, file = 0;
+        if (std::sscanf(line.c_str(), "WELCOME %d %u %u %u", &registration.drone_id, &control, &telemetry, &file) != 4 ||
+            control > 65535 || telemetry > 65535 || file > 65535)
+        {
+            if (error)
+                *error = line.compare(0, 7, "REJECT ") == 0 ? line.substr(7) : "malformed reply: " + line;
+            return false;
+        }
+        registration.control_port = static_cast<unsigned short>(control);
+        registration.telemetry_port = static_cast<unsigned short>(telemetry);
+        registration.file_port = static_cast<unsigned short>(file);
+        return true;
+    }
+
+    inline std::string format_file_header(int drone_id) { return "Drone " + std::to_string(drone_id) + "\n"; }
+
+    inline bool parse_file_header(const std::string &line, int &drone_id)
+    {
+        return std::sscanf(line.c_str(), "Drone %d", &drone_id) == 1 && drone_id >= 0;
+    }
+
+    // Reads one '\n'-terminated line (without the newline) from a socket, giving up after
+    // timeout_ms or max_length bytes. Bytes received after the newline are left in rest.
+    // Waits with poll, so a silent peer cannot hold the caller past the timeout.
+    inline bool read_line(boost::asio::ip::tcp::socket &socket, std::string &line, std::string &rest, int timeout_ms, size_t max_length = 256)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        std::string received;
+        char buffer[512];
+        while (true)
+        {
+            size_t newline = received.find('\n');
+            if (newline != std::string::npos)
+            {
+                line = received.substr(0, newline);
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                rest = received.substr(newline + 1);
+                return true;
+            }
+            if (received.size() > max_length)
+                return false;
+
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            pollfd ready{socket.native_handle(), POLLIN, 0};
+            if (remaining <= 0 || ::poll(&ready, 1, static_cast<int>(remaining)) <= 0)
+                return false;
+
+            boost::system::error_code error;
+            size_t length = socket.read_some(boost::asio::buffer(buffer), error);
+            if (error)
+                return false;
+            received.append(buffer, length);
+        }
+    }
+
+    // Registers with the server and returns the identity and ports it assigned.
+    inline bool register_drone(boost::asio::io_context &io_context, const std::string &server_ip, unsigned short registration_port,
+                               int drone_id, unsigned short control_port, Registration &registration, std::string *error = nullptr)
+    {
+        try
+        {
+            boost::asio::ip::tcp::socket socket(io_context);
+            socket.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::make_address(server_ip), registration_port));
+            boost::asio::write(socket, boost::asio::buffer(format_register_request(drone_id, control_port)));
+
+            std::string line, rest;
+            if (!read_line(socket, line, rest, 5000))
+            {
+                if (error)
+                    *error = "no reply from registration server";
+                return false;
+            }
+            return parse_welcome(line, registration, error);
+        }
+        catch (std::exception &e)
+        {
+            if (error)
+                *error = e.what();
+            return false;
+        }
+    }
+
+    // The server's view of the fleet: which drones exist and where their commands go.
+    // Drones either register at runtime or are listed statically in the server config.
+    class DroneRegistry
+    {
+    public:
+        explicit DroneRegistry(unsigned control_port_base = 10000, size_t max_drones = 65536)
+            : control_port_base_(control_port_base), max_drones_(max_drones) {}
+
+        void configure(unsigned control_port_base, size_t max_drones)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            control_port_base_ = control_port_base;
+            max_drones_ = max_drones;
+        }
+
+        // Assigns an identity and control port. A drone re-registering (e.g. after a
+        // restart, or after the server restarted) keeps the id it asks for. Ids run from 1
+        // to max_id(); anything else is refused, so a request cannot push the next free id
+        // past the control ports. An id held from another address is refused while
+        // holder_live says that drone is still reporting, so one client cannot take over
+        // another drone's command channel.
+        bool enroll(int requested_id, unsigned short requested_port, const std::string &address, bool holder_live, DroneAddress &out, std::string *error = nullptr)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (requested_id < 0 || requested_id > max_id())
+            {
+                if (error)
+                    *error = "drone id must be between 1 and " + std::to_string(max_id());
+                return false;
+            }
+            int drone_id = requested_id;
+            auto held = drones_.find(drone_id);
+            if (drone_id != 0 && held != drones_.end() && held->second.address != address && holder_live)
+            {
+                if (error)
+                    *error = "drone " + std::to_string(drone_id) + " is registered from " + held->second.address + " and still reporting";
+                return false;
+            }
+            if (drone_id == 0)
+            {
+                // Next free id, wrapping to 1 so a high id taken on request does not use up the range
+                for (int tried = 0; tried < max_id(); ++tried, ++next_id_)
+                {
+                    if (next_id_ > max_id())
+                        next_id_ = 1;
+                    if (!drones_.count(next_id_))
+                    {
+                        drone_id = next_id_;
+                        break;
+                    }
+                }
+            }
+            if (drone_id == 0 || (!drones_.count(drone_id) && drones_.size() >= max_drones_))
+            {
+                if (error)
+                    *error = "fleet is full";
+                return false;
+            }
+
+            unsigned port = requested_port != 0 ? requested_port : control_port_base_ + static_cast<unsigned>(drone_id);
+            if (port > 65535)
+            {
+                if (error)
+                    *error = "no control port left for drone " + std::to_string(drone_id);
+                return false;
+            }
+
+            out = DroneAddress{drone_id, address, static_cast<unsigned short>(port)};
+            drones_[drone_id] = out;
+            next_id_ = std::max(next_id_, drone_id + 1);
+            return true;
+        }
+
+        void add(const DroneAddress &drone)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            drones_[drone.drone_id] = drone; // enroll() skips ids taken here
+        }
+
+        bool lookup(int drone_id, DroneAddress &out) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = drones_.find(drone_id);
+            if (it == drones_.end())
+                return false;
+            out = it->second;
+            return true;
+        }
+
+        std::vector<DroneAddress> list() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::vector<DroneAddress> drones;
+            drones.reserve(drones_.size());
+            for (const auto &entry : drones_)
+                drones.push_back(entry.second);
+            std::sort(drones.begin(), drones.end(), [](const DroneAddress &a, const DroneAddress &b)
+                      { return a.drone_id < b.drone_id; });
+            return drones;
+        }
+
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return drones_.size();
+        }
+
+    private:
+        // Highest id enroll() hands out: within max_drones_, and low enough that
+        // control_port_base_ + id is still a port
+        int max_id() const
+        {
+            unsigned by_port = control_port_base_ < 65535 ? 65535 - control_port_base_ : 0;
+            return static_cast<int>(std::min<size_t>(max_drones_, by_port));
+        }
+
+        mutable std::mutex mutex_;
+        std::unordered_map<int, DroneAddress> drones_;
+        unsigned control_port_base_;
+        size_t max_drones_;
+        int next_id_ = 1;
+    };
+}
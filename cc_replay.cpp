@@ -0,0 +1,208 @@
+#include <iostream>
+#include <boost/asio.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include "cc_capture.hpp"
+
+using boost::asio::ip::tcp;
+using boost::asio::ip::udp;
+
+// One replayed connection (or command stream) from the capture
+struct ReplaySession
+{
+    cc::CaptureChannel channel;
+    std::unique_ptr<tcp::socket> tcp_socket;
+    std::unique_ptr<udp::socket> udp_socket;
+    udp::endpoint udp_target;
+};
+
+// Percentile over an already-sorted sample vector (microseconds)
+double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1));
+    return sorted[index];
+}
+
+void print_timing(const std::string &label, std::vector<double> &samples)
+{
+    std::sort(samples.begin(), samples.end());
+    std::cout << label << " (us): p50=" << percentile(samples, 0.50)
+              << " p90=" << percentile(samples, 0.90)
+              << " p99=" << percentile(samples, 0.99)
+              << " max=" << (samples.empty() ? 0.0 : samples.back()) << std::endl;
+}
+
+void print_usage(const char *program)
+{
+    std::cout << "Usage: " << program << " <capture file> [--host <server ip>] [--drone-host <drone ip>] [--speed <N|max>]" << std::endl;
+    std::cout << "  --speed 1    replay at the recorded pace (default)" << std::endl;
+    std::cout << "  --speed 10   replay ten times faster" << std::endl;
+    std::cout << "  --speed max  replay as fast as possible" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string capture_path = argv[1];
+    std::string server_host = "127.0.0.1";
+    std::string drone_host;
+    double speed = 1.0; // 0 means as fast as possible
+
+    for (int i = 2; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--host") == 0 && i + 1 < argc)
+            server_host = argv[++i];
+        else if (std::strcmp(argv[i], "--drone-host") == 0 && i + 1 < argc)
+            drone_host = argv[++i];
+        else if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc)
+        {
+            std::string value = argv[++i];
+            speed = (value == "max") ? 0.0 : std::stod(value);
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (drone_host.empty())
+        drone_host = server_host;
+
+    cc::CaptureReader reader;
+    if (!reader.open(capture_path))
+    {
+        std::cerr << "Failed to open capture file (missing or not a capture): " << capture_path << std::endl;
+        return 1;
+    }
+
+    std::cout << "Replaying " << capture_path << " against " << server_host
+              << " at " << (speed == 0.0 ? std::string("max") : std::to_string(speed) + "x") << " speed" << std::endl;
+
+    boost::asio::io_context io_context;
+    std::map<uint32_t, ReplaySession> sessions;
+
+    size_t messages[3] = {0, 0, 0};
+    size_t bytes[3] = {0, 0, 0};
+    size_t errors = 0;
+    std::vector<double> write_time_us; // Time spent in write/send_to only; the server sends no acknowledgement
+    std::vector<double> schedule_lag_us;
+
+    auto replay_start = std::chrono::steady_clock::now();
+    cc::CaptureRecordHeader header;
+    std::string payload;
+
+    while (reader.next(header, payload))
+    {
+        if (header.channel > static_cast<uint8_t>(cc::CaptureChannel::File))
+        {
+            std::cerr << "Corrupt record (unknown channel " << int(header.channel) << "), stopping." << std::endl;
+            ++errors;
+            break;
+        }
+        auto channel = static_cast<cc::CaptureChannel>(header.channel);
+        auto kind = static_cast<cc::CaptureKind>(header.kind);
+
+        // Pace the replay against the recorded timestamps
+        auto target = replay_start;
+        if (speed > 0.0)
+        {
+            target += std::chrono::nanoseconds(static_cast<uint64_t>(header.ts_ns / speed));
+            std::this_thread::sleep_until(target);
+        }
+
+        try
+        {
+            if (kind == cc::CaptureKind::Open)
+            {
+                ReplaySession session;
+                session.channel = channel;
+                if (channel == cc::CaptureChannel::Command)
+                {
+                    // Commands flow server -> drone, so they are re-sent to the drone's control port
+                    session.udp_socket.reset(new udp::socket(io_context));
+                    session.udp_socket->open(udp::v4());
+                    session.udp_target = udp::endpoint(boost::asio::ip::make_address(drone_host), header.port);
+                }
+                else
+                {
+                    session.tcp_socket.reset(new tcp::socket(io_context));
+                    session.tcp_socket->connect(tcp::endpoint(boost::asio::ip::make_address(server_host), header.port));
+                }
+                sessions[header.session] = std::move(session);
+            }
+            else if (kind == cc::CaptureKind::Data)
+            {
+                auto it = sessions.find(header.session);
+                if (it == sessions.end())
+                    continue; // Session was opened before the capture started
+
+                auto send_start = std::chrono::steady_clock::now();
+                if (it->second.tcp_socket)
+                    boost::asio::write(*it->second.tcp_socket, boost::asio::buffer(payload));
+                else
+                    it->second.udp_socket->send_to(boost::asio::buffer(payload), it->second.udp_target);
+                auto send_end = std::chrono::steady_clock::now();
+
+                write_time_us.push_back(std::chrono::duration<double, std::micro>(send_end - send_start).count());
+                if (speed > 0.0)
+                    schedule_lag_us.push_back(std::chrono::duration<double, std::micro>(send_start - target).count());
+
+                messages[header.channel] += 1;
+                bytes[header.channel] += payload.size();
+            }
+            else if (kind == cc::CaptureKind::Close)
+            {
+                auto it = sessions.find(header.session);
+                if (it == sessions.end())
+                    continue;
+
+                boost::system::error_code ignored;
+                if (it->second.tcp_socket)
+                {
+                    it->second.tcp_socket->shutdown(tcp::socket::shutdown_both, ignored);
+                    it->second.tcp_socket->close(ignored);
+                }
+                sessions.erase(it);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Replay error on session " << header.session << ": " << e.what() << std::endl;
+            ++errors;
+            sessions.erase(header.session);
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - replay_start).count();
+    size_t total_messages = messages[0] + messages[1] + messages[2];
+    size_t total_bytes = bytes[0] + bytes[1] + bytes[2];
+
+    std::cout << "Replay finished in " << elapsed << " s" << std::endl;
+    std::cout << "  telemetry: " << messages[0] << " messages, " << bytes[0] << " bytes" << std::endl;
+    std::cout << "  commands:  " << messages[1] << " messages, " << bytes[1] << " bytes" << std::endl;
+    std::cout << "  files:     " << messages[2] << " chunks, " << bytes[2] << " bytes" << std::endl;
+    std::cout << "  errors:    " << errors << std::endl;
+    if (elapsed > 0.0)
+    {
+        std::cout << "Throughput: " << total_messages / elapsed << " msg/s, "
+                  << total_bytes / elapsed / (1024.0 * 1024.0) << " MiB/s" << std::endl;
+    }
+    print_timing("Write time", write_time_us);
+    if (speed > 0.0)
+        print_timing("Schedule lag", schedule_lag_us);
+
+    return errors == 0 ? 0 : 2;
+}
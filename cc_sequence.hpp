@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+// Per-drone telemetry sequence tracking for datagram telemetry.
+//
+// Each drone numbers its telemetry samples 1, 2, 3, ... within a session it picks at
+// start-up, so a restart shows up as a new session. The server keeps, per drone,
+// the highest sequence seen and a 64-bit bitmap of which of the preceding 64 numbers
+// have arrived (bit i set = highest - i received). That classifies every sample as
+// in order, after a gap, late (fills an earlier gap), a duplicate, or too old to tell,
+// and counts losses as gaps that were never filled. Only samples that advance the
+// highest sequence are the drone's latest state; late samples are counted but never
+// overwrite a newer position.
+namespace cc
+{
+    enum class SequenceVerdict
+    {
+        First,     // First sample from this drone
+        InOrder,   // highest + 1
+        Gap,       // Beyond highest + 1; the numbers skipped count as lost until they arrive
+        Late,      // Inside the window and not seen before: fills a gap
+        Duplicate, // Already seen
+        Stale,     // Older than the window; dropped without affecting loss
+        Restart    // New session: the drone restarted and numbers from scratch
+    };
+
+    // Whether a sample with this verdict carries the drone's newest state
+    inline bool is_latest(SequenceVerdict verdict)
+    {
+        return verdict == SequenceVerdict::First || verdict == SequenceVerdict::InOrder ||
+               verdict == SequenceVerdict::Gap || verdict == SequenceVerdict::Restart;
+    }
+
+    inline const char *verdict_name(SequenceVerdict verdict)
+    {
+        switch (verdict)
+        {
+        case SequenceVerdict::First: return "first";
+        case SequenceVerdict::InOrder: return "in order";
+        case SequenceVerdict::Gap: return "gap";
+        case SequenceVerdict::Late: return "late";
+        case SequenceVerdict::Duplicate: return "duplicate";
+        case SequenceVerdict::Stale: return "stale";
+        case SequenceVerdict::Restart: return "restart";
+        }
+        return "unknown";
+    }
+
+    struct SequenceStats
+    {
+        uint64_t highest = 0;
+        uint64_t received = 0;   // Distinct samples accepted (latest or late)
+        uint64_t expected = 0;   // Sequence numbers the drone has used, across restarts
+        uint64_t lost = 0;       // Skipped numbers that have not (yet) arrived
+        uint64_t gaps = 0;       // Times the sequence jumped forward
+        uint64_t reordered = 0;  // Late arrivals that filled a gap
+        uint64_t duplicates = 0;
+        uint64_t stale = 0;
+        uint64_t restarts = 0;
+
+        double loss_rate() const { return expected > 0 ? static_cast<double>(lost) / static_cast<double>(expected) : 0.0; }
+
+        void add(const SequenceStats &other)
+        {
+            received += other.received;
+            expected += other.expected;
+            lost += other.lost;
+            gaps += other.gaps;
+            reordered += other.reordered;
+            duplicates += other.duplicates;
+            stale += other.stale;
+            restarts += other.restarts;
+        }
+    };
+
+    class SequenceWindow
+    {
+    public:
+        static constexpr uint64_t window = 64;
+
+        SequenceVerdict observe(uint32_t session, uint64_t seq)
+        {
+            if (stats_.received == 0 && stats_.highest == 0)
+            {
+                session_ = session;
+                start(seq);
+                return SequenceVerdict::First;
+            }
+
+            if (session != session_)
+            {
+                // Delayed samples from the session the drone restarted out of
+                if (restarted_ && session == previous_session_)
+                {
+                    stats_.stale++;
+                    return SequenceVerdict::Stale;
+                }
+                previous_session_ = session_;
+                session_ = session;
+                restarted_ = true;
+                stats_.restarts++;
+                start(seq);
+                return SequenceVerdict::Restart;
+            }
+
+            uint64_t highest = stats_.highest;
+            if (seq > highest)
+            {
+                uint64_t advance = seq - highest;
+                seen_ = advance >= window ? 1 : (seen_ << advance) | 1;
+                stats_.highest = seq;
+                stats_.expected += advance;
+                stats_.received++;
+                if (advance == 1)
+                    return SequenceVerdict::InOrder;
+                stats_.lost += advance - 1;
+                stats_.gaps++;
+                return SequenceVerdict::Gap;
+            }
+
+            uint64_t offset = highest - seq;
+            if (offset >= window)
+            {
+                stats_.stale++;
+                return SequenceVerdict::Stale;
+            }
+
+            uint64_t bit = uint64_t(1) << offset;
+            if (seen_ & bit)
+            {
+                stats_.duplicates++;
+                return SequenceVerdict::Duplicate;
+            }
+            seen_ |= bit;
+            stats_.received++;
+            stats_.reordered++;
+            if (stats_.lost > 0)
+                stats_.lost--;
+            return SequenceVerdict::Late;
+        }
+
+        const SequenceStats &stats() const { return stats_; }
+
+    private:
+        // Counts from seq onwards; numbers below it were never ours to expect
+        void start(uint64_t seq)
+        {
+            stats_.highest = seq;
+            stats_.expected++;
+            stats_.received++;
+            seen_ = 1;
+        }
+
+        SequenceStats stats_;
+        uint64_t seen_ = 0;
+        uint32_t session_ = 0;
+        uint32_t previous_session_ = 0;
+        bool restarted_ = false;
+    };
+
+    // Sequence windows for the whole fleet. observe() is called from the single state
+    // update stage; the mutex only orders it against operator queries.
+    class SequenceTracker
+    {
+    public:
+        SequenceVerdict observe(int drone_id, uint32_t session, uint64_t seq)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return windows_[drone_id].observe(session, seq);
+        }
+
+        bool stats_of(int drone_id, SequenceStats &out) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = windows_.find(drone_id);
+            if (it == windows_.end())
+                return false;
+            out = it->second.stats();
+            return true;
+        }
+
+        SequenceStats totals() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            SequenceStats total;
+            for (const auto &entry : windows_)
+                total.add(entry.second.stats());
+            return total;
+        }
+
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return windows_.size();
+        }
+
+    private:
+        mutable std::mutex mutex_;
+        std::unordered_map<int, SequenceWindow> windows_;
+    };
+}
@@ -4,53 +4,127 @@
 #include <string>
 #include <fstream>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstring>
+#include "cc_capture.hpp"
+#include "cc_channel.hpp"
+#include "cc_config.hpp"
+#include "cc_commands.hpp"
+#include "cc_pipeline.hpp"
+#include "cc_trace.hpp"
+#include <sstream>
+#include <vector>
+#include <memory>
+#include <algorithm>
 
 using boost::asio::ip::tcp;
 using boost::asio::ip::udp;
 
-// XOR Encryption/Decryption Function
-std::string xor_cipher(const std::string &data, char key)
+// Optional capture of all three channels (enabled with --record <path>)
+cc::CaptureWriter recorder;
+
+// Wire configuration. cc_drone XOR-encrypts telemetry and commands; file transfers are plaintext.
+typedef cc::XorCipher<0x42> LinkCipher;
+typedef cc::Channel<cc::TcpStream, cc::LineFraming, LinkCipher, cc::StringCodec> TelemetryChannel;
+typedef cc::Channel<cc::UdpDatagram, cc::DatagramFraming, LinkCipher, cc::CommandCodec> CommandChannel;
+typedef cc::Channel<cc::TcpStream, cc::RawFraming, cc::NoCipher, cc::StringCodec> FileChannel;
+
+// Signalled once the first telemetry arrives, so the command sender wakes immediately instead of sleep-polling
+std::mutex telemetry_mutex;
+std::condition_variable telemetry_ready;
+
+// Command-to-effect latency traces, completed from the ids the drone echoes in telemetry
+cc::LatencyTracer tracer;
+
+// One telemetry line moving through the pipeline
+struct TelemetryLine
+{
+    std::string data;
+    uint64_t received_ns = 0; // Monotonic time the line came off the socket
+};
+
+// Telemetry ingest pipeline: socket thread -> decrypt -> state update -> print
+std::unique_ptr<cc::Stage<TelemetryLine>> decrypt_stage;
+std::unique_ptr<cc::Stage<TelemetryLine>> state_stage;
+std::unique_ptr<cc::Stage<TelemetryLine>> sink_stage;
+
+void start_ingest_pipeline(const cc::StageOptions &options, const std::vector<int> &cores, std::atomic<bool> &telemetry_received)
+{
+    auto options_for = [&options, &cores](size_t stage)
+    {
+        cc::StageOptions stage_options = options;
+        stage_options.core = stage < cores.size() ? cores[stage] : -1;
+        return stage_options;
+    };
+    decrypt_stage.reset(new cc::Stage<TelemetryLine>("decrypt", options_for(0)));
+    state_stage.reset(new cc::Stage<TelemetryLine>("state", options_for(1)));
+    sink_stage.reset(new cc::Stage<TelemetryLine>("sink", options_for(2)));
+
+    sink_stage->start([](TelemetryLine &decrypted)
+                      { std::cout << "Received telemetry data: " << decrypted.data << std::endl; });
+
+    state_stage->start([&telemetry_received](TelemetryLine &decrypted)
+                       {
+                           tracer.telemetry_received(decrypted.data, decrypted.received_ns);
+                           if (!telemetry_received.exchange(true)) // Set flag to indicate telemetry data was received
+                           {
+                               std::lock_guard<std::mutex> lock(telemetry_mutex);
+                               telemetry_ready.notify_all();
+                           }
+                           sink_stage->push(std::move(decrypted)); });
+
+    // Decrypts in place: the line already belongs to this stage, so no copy is needed
+    decrypt_stage->start([](TelemetryLine &line)
+                         {
+                             TelemetryChannel::cipher::apply(&line.data[0], line.data.size());
+                             state_stage->push(std::move(line)); });
+}
+
+// Upstream first, so each stage drains into one that is still running
+void stop_ingest_pipeline()
 {
-    std::string result = data;
-    for (auto &c : result)
-        c ^= key;
-    return result;
+    decrypt_stage->stop();
+    state_stage->stop();
+    sink_stage->stop();
 }
 
 // Receive Telemetry Data (TCP) from Drone
-void receive_telemetry_data(boost::asio::io_context &io_context, unsigned short port, char key, std::atomic<bool> &telemetry_received)
+void receive_telemetry_data(boost::asio::io_context &io_context, unsigned short port)
 {
     try
     {
         tcp::acceptor acceptor(io_context, tcp::endpoint(tcp::v4(), port));
         std::cout << "Telemetry Data Server started on port " << port << std::endl;
 
-        tcp::socket socket(io_context);
-        acceptor.accept(socket);
+        TelemetryChannel telemetry(io_context);
+        acceptor.accept(telemetry.transport().socket());
 
         // Notify about drone connection
         std::cout << "A drone has connected!" << std::endl;
+        uint32_t session = recorder.open_session(cc::CaptureChannel::Telemetry, port);
 
         try
         {
             while (true)
             {
-                boost::asio::streambuf buffer;
-                boost::asio::read_until(socket, buffer, "\n");
-                std::istream input_stream(&buffer);
-                std::string data;
-                std::getline(input_stream, data);
+                cc::Frame frame;
+                boost::system::error_code error;
+                if (!telemetry.receive_frame(frame, error))
+                    throw boost::system::system_error(error);
+                uint64_t received_ns = cc::monotonic_ns();
 
-                std::string decrypted_data = xor_cipher(data, key);
-                std::cout << "Received telemetry data: " << decrypted_data << std::endl;
+                recorder.data(session, cc::CaptureChannel::Telemetry, port, frame.data, frame.wire_size);
 
-                telemetry_received.store(true); // Set flag to indicate telemetry data was received
+                // Decryption, state updates and printing happen on the pipeline stages
+                decrypt_stage->push(TelemetryLine{std::string(frame.data, frame.size), received_ns});
             }
         }
         catch (const std::exception &e)
         {
             std::cerr << "Exception in telemetry session: " << e.what() << std::endl;
         }
+        recorder.close_session(session, cc::CaptureChannel::Telemetry, port);
     }
     catch (const std::exception &e)
     {
@@ -59,47 +133,76 @@ void receive_telemetry_data(boost::asio::io_context &io_context, unsigned short
 }
 
 // Send Control Commands (UDP) from Server to Drone
-void send_control_commands(boost::asio::io_context &io_context, const std::string &drone_ip, unsigned short port, char key, std::atomic<bool> &telemetry_received)
+void send_control_commands(boost::asio::io_context &io_context, const std::string &drone_ip, unsigned short port, std::atomic<bool> &telemetry_received)
 {
     try
     {
-        udp::socket socket(io_context);
         udp::endpoint drone_endpoint(boost::asio::ip::make_address(drone_ip), port);
-
-        socket.open(udp::v4()); // Open the UDP socket
+        CommandChannel control(cc::UdpDatagram(udp::socket(io_context, udp::v4()), drone_endpoint));
 
         // Wait until telemetry data is received
-        while (!telemetry_received.load())
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Check periodically
+            std::unique_lock<std::mutex> lock(telemetry_mutex);
+            telemetry_ready.wait(lock, [&telemetry_received]()
+                                 { return telemetry_received.load(); });
         }
 
-        std::cout << "Telemetry data received. Control Command Sender started. (NOTE: move front/back/left/right commands only ENABLED)" << std::endl;
+        uint32_t session = recorder.open_session(cc::CaptureChannel::Command, port);
+
+        std::cout << "Telemetry data received. Control Command Sender started. Commands: " << cc::command_usage() << std::endl;
 
         while (true)
         {
-            std::string command;
-            std::getline(std::cin, command);
+            std::string input;
+            if (!std::getline(std::cin, input))
+                break; // Operator input closed
 
-            // Validate command
-            if (command != "move front" && command != "move back" && command != "move left" && command != "move right")
+            if (input == "trace")
+            {
+                tracer.print_summary();
+                continue;
+            }
+            if (input.compare(0, 13, "trace export ") == 0)
             {
-                std::cout << "Invalid command. Please enter one of the following: move front, move back, move left, move right." << std::endl;
+                std::string path = input.substr(13);
+                if (tracer.export_csv(path))
+                    std::cout << "Exported command traces to " << path << " and histograms to " << path << ".hist" << std::endl;
+                else
+                    std::cout << "Failed to write " << path << std::endl;
                 continue;
             }
 
-            // Encrypt and send the command
-            std::string encrypted_command = xor_cipher(command, key) + "\n"; // Add newline character
+            if (input == "stats")
+            {
+                cc::print_stage_stats({decrypt_stage->stats(), state_stage->stats(), sink_stage->stats()});
+                continue;
+            }
+
+            // Parse and validate the command against the shared schema
+            cc::Command command;
+            std::string parse_error;
+            if (!cc::parse_command(input, command, &parse_error))
+            {
+                std::cout << "Invalid command (" << parse_error << "). Please enter one of the following: " << cc::command_usage() << std::endl;
+                continue;
+            }
+
+            // Encoded to the binary opcode form and encrypted by the channel
+            command.id = tracer.next_id();
             boost::system::error_code error;
-            socket.send_to(boost::asio::buffer(encrypted_command), drone_endpoint, 0, error);
+            uint64_t sent_ns = cc::monotonic_ns();
+            control.send(command, error);
 
             if (error)
             {
                 std::cerr << "Error sending command: " << error.message() << std::endl;
                 continue;
             }
+            tracer.command_sent(command.id, 0, sent_ns); // Only commands that left can be echoed back
+
+            recorder.data(session, cc::CaptureChannel::Command, port, control.sent().data(), control.sent().size());
 
-            std::cout << "Sent command: " << command << " to drone at " << drone_ip << std::endl;
+            std::cout << "Sent command: " << cc::format_command(command) << " to drone at " << drone_ip << std::endl;
         }
     }
     catch (const std::exception &e)
@@ -118,10 +221,11 @@ void receive_file_transfer(boost::asio::io_context &io_context, unsigned short p
 
         while (true)
         {
-            tcp::socket socket(io_context);
-            acceptor.accept(socket);
+            FileChannel transfer(io_context);
+            acceptor.accept(transfer.transport().socket());
 
             std::cout << "A drone has connected for file transfer!" << std::endl;
+            uint32_t session = recorder.open_session(cc::CaptureChannel::File, port);
 
             try
             {
@@ -132,27 +236,22 @@ void receive_file_transfer(boost::asio::io_context &io_context, unsigned short p
                     return;
                 }
 
-                boost::asio::streambuf buffer;
                 std::cout << "Receiving file data..." << std::endl;
 
                 // Receive file data
                 while (true)
                 {
+                    cc::Frame chunk;
                     boost::system::error_code error;
-                    size_t bytes_received = boost::asio::read(socket, buffer, boost::asio::transfer_at_least(1), error);
-
-                    if (error && error != boost::asio::error::eof)
+                    if (!transfer.receive_frame(chunk, error))
                     {
-                        std::cerr << "Error receiving file data: " << error.message() << std::endl;
-                        break;
-                    }
-
-                    if (bytes_received == 0)
+                        if (error != boost::asio::error::eof)
+                            std::cerr << "Error receiving file data: " << error.message() << std::endl;
                         break; // End of file
+                    }
 
-                    std::ostream output_stream(&buffer);
-                    output_file.write(boost::asio::buffer_cast<const char *>(buffer.data()), buffer.size());
-                    buffer.consume(buffer.size());
+                    recorder.data(session, cc::CaptureChannel::File, port, chunk.data, chunk.size);
+                    output_file.write(chunk.data, chunk.size);
                 }
 
                 output_file.close();
@@ -166,6 +265,7 @@ void receive_file_transfer(boost::asio::io_context &io_context, unsigned short p
             {
                 std::cerr << "Exception in file transfer session: " << e.what() << std::endl;
             }
+            recorder.close_session(session, cc::CaptureChannel::File, port);
         }
     }
     catch (const std::exception &e)
@@ -174,29 +274,74 @@ void receive_file_transfer(boost::asio::io_context &io_context, unsigned short p
     }
 }
 
-int main()
+// Settings come from --config <file> and the command line (see cc_config.hpp):
+//   drone, control_port, telemetry_port, file_port, file_name, record,
+//   queue_depth, backpressure, pin_stages, trace_timeout, trace_keep
+int main(int argc, char *argv[])
 {
-    char key = 0x42; // XOR cipher key
-    unsigned short control_port = 9000;
-    unsigned short telemetry_port = 9001;
-    unsigned short file_port = 9002; // Port for file transfer
+    cc::Config config;
+    std::string config_error;
+    if (!config.load(argc, argv, &config_error))
+    {
+        std::cerr << config_error << std::endl;
+        return 1;
+    }
+
+    tracer.configure(static_cast<uint64_t>(std::max(0.0, config.get_double("trace_timeout", 60.0)) * 1e9), // Seconds before an unanswered command counts as lost
+                     static_cast<size_t>(std::max(1L, config.get_int("trace_keep", 100000))));             // Completed traces kept for trace export
+
+    cc::StageOptions stage_options;
+    stage_options.capacity = static_cast<size_t>(std::max(2L, config.get_int("queue_depth", static_cast<long>(stage_options.capacity))));
+    if (config.has("backpressure") && !cc::parse_backpressure(config.get("backpressure"), stage_options.policy))
+    {
+        std::cerr << "Unknown backpressure policy (use block, drop-oldest or sample): " << config.get("backpressure") << std::endl;
+        return 1;
+    }
+
+    // Comma-separated cores for the decrypt, state and sink stages, e.g. 1,2,3 (-1 = unpinned)
+    std::vector<int> stage_cores;
+    std::istringstream cores(config.get("pin_stages"));
+    std::string core;
+    while (std::getline(cores, core, ','))
+        stage_cores.push_back(std::atoi(core.c_str()));
+
+    if (config.has("record"))
+    {
+        std::string capture_path = config.get("record");
+        if (!recorder.open(capture_path))
+        {
+            std::cerr << "Failed to open capture file: " << capture_path << std::endl;
+            return 1;
+        }
+        std::cout << "Recording all channels to " << capture_path << std::endl;
+    }
+
+    std::string drone_ip = config.get("drone", "127.0.0.1");
+    unsigned short control_port = static_cast<unsigned short>(config.get_int("control_port", 9000));
+    unsigned short telemetry_port = static_cast<unsigned short>(config.get_int("telemetry_port", 9001));
+    unsigned short file_port = static_cast<unsigned short>(config.get_int("file_port", 9002)); // Port for file transfer
+    std::string file_name = config.get("file_name", "received_file.bin");
 
     boost::asio::io_context io_context;
     std::atomic<bool> telemetry_received(false); // Flag to ensure telemetry is received first
     std::atomic<bool> file_received(false);      // Flag to indicate file was received
 
+    start_ingest_pipeline(stage_options, stage_cores, telemetry_received);
+
     // Start threads for receiving telemetry data and file transfer
-    std::thread telemetry_thread(receive_telemetry_data, std::ref(io_context), telemetry_port, key, std::ref(telemetry_received));
-    std::thread file_thread(receive_file_transfer, std::ref(io_context), file_port, "received_file.bin", std::ref(file_received));
+    std::thread telemetry_thread(receive_telemetry_data, std::ref(io_context), telemetry_port);
+    std::thread file_thread(receive_file_transfer, std::ref(io_context), file_port, file_name, std::ref(file_received));
 
     // Wait for telemetry to be received before sending control commands
-    std::thread control_thread(send_control_commands, std::ref(io_context), "127.0.0.1", control_port, key, std::ref(telemetry_received));
+    std::thread control_thread(send_control_commands, std::ref(io_context), drone_ip, control_port, std::ref(telemetry_received));
 
     // Join threads to the main thread
     telemetry_thread.join();
     file_thread.join();
     control_thread.join();
 
+    stop_ingest_pipeline();
+    recorder.close();
     std::cout << "Exiting program." << std::endl;
     return 0;
 }
\ No newline at end of file
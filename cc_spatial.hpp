@@ -0,0 +1,514 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Spatial index over the latest position of every drone in the fleet.
+//
+// The index is a uniform hash grid: each drone lives in the cell containing its
+// latest (x, y) and moves between cells only when it crosses a cell boundary.
+// Telemetry threads never touch the grid directly. They drop updates into a small
+// staging buffer (one short mutex hold) and an index thread applies them in
+// batches, so ingestion is never blocked by a query or a conflict scan.
+//
+// Every query is bounded: k-nearest searches only the occupied part of the grid and
+// falls back to ordering occupied cells (never every drone), the conflict scan stops
+// at a pair limit, and drones that stop reporting are evicted.
+namespace cc
+{
+    struct DronePosition
+    {
+        int drone_id;
+        double x;
+        double y;
+    };
+
+    struct ConflictPair
+    {
+        int first;
+        int second;
+        double distance;
+    };
+
+    // One conflict pass. When truncated, more pairs exist than were returned.
+    struct ConflictScan
+    {
+        std::vector<ConflictPair> pairs;
+        bool truncated = false;
+    };
+
+    class SpatialIndex
+    {
+    public:
+        // cell_size should be around the typical query radius / conflict distance
+        explicit SpatialIndex(double cell_size = 50.0) : cell_size_(cell_size) {}
+
+        ~SpatialIndex() { stop(); }
+
+        // Called from telemetry threads. Cheap and never waits on readers.
+        void submit(int drone_id, double x, double y)
+        {
+            {
+                std::lock_guard<std::mutex> lock(staging_mutex_);
+                staging_.push_back(DronePosition{drone_id, x, y});
+            }
+            staging_ready_.notify_one();
+        }
+
+        // Starts the index thread and a periodic pass that evicts drones silent for longer
+        // than expire_after (0 = never) and, when conflict_distance > 0, reports up to
+        // max_pairs conflicting pairs
+        void start(double conflict_distance, std::chrono::milliseconds conflict_period,
+                   std::function<void(const ConflictScan &)> on_conflicts,
+                   std::chrono::nanoseconds expire_after = std::chrono::nanoseconds(0), size_t max_pairs = 10000)
+        {
+            running_.store(true);
+            index_thread_ = std::thread([this]()
+                                        { run_index(); });
+            if (conflict_distance > 0.0 || expire_after.count() > 0)
+            {
+                conflict_thread_ = std::thread([this, conflict_distance, conflict_period, on_conflicts, expire_after, max_pairs]()
+                                               { run_conflicts(conflict_distance, conflict_period, on_conflicts, expire_after, max_pairs); });
+            }
+        }
+
+        void stop()
+        {
+            if (!running_.exchange(false))
+                return;
+            staging_ready_.notify_all();
+            if (index_thread_.joinable())
+                index_thread_.join();
+            if (conflict_thread_.joinable())
+                conflict_thread_.join();
+        }
+
+        // Applies staged updates immediately (used when the index runs without its own thread)
+        void apply_pending()
+        {
+            std::vector<DronePosition> batch;
+            {
+                std::lock_guard<std::mutex> lock(staging_mutex_);
+                batch.swap(staging_);
+            }
+            apply(batch);
+        }
+
+        // Removes drones whose last update was applied before cutoff (steady_clock ns).
+        // Returns how many were removed.
+        size_t expire(uint64_t cutoff_ns)
+        {
+            std::unique_lock<std::shared_mutex> lock(grid_mutex_);
+            size_t removed = 0;
+            for (auto it = drones_.begin(); it != drones_.end();)
+            {
+                if (it->second.seen_ns < cutoff_ns)
+                {
+                    remove_from_cell(it->second.cell, it->first);
+                    it = drones_.erase(it);
+                    ++removed;
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            if (removed > 0)
+                recompute_bounds();
+            return removed;
+        }
+
+        size_t size() const
+        {
+            std::shared_lock<std::shared_mutex> lock(grid_mutex_);
+            return drones_.size();
+        }
+
+        bool position_of(int drone_id, DronePosition &out) const
+        {
+            std::shared_lock<std::shared_mutex> lock(grid_mutex_);
+            auto it = drones_.find(drone_id);
+            if (it == drones_.end())
+                return false;
+            out = DronePosition{drone_id, it->second.x, it->second.y};
+            return true;
+        }
+
+        // All drones within radius of (x, y)
+        std::vector<DronePosition> within_radius(double x, double y, double radius) const
+        {
+            std::vector<DronePosition> result;
+            double radius_sq = radius * radius;
+            std::shared_lock<std::shared_mutex> lock(grid_mutex_);
+            for_cells(x - radius, y - radius, x + radius, y + radius, [&](const std::vector<DronePosition> &cell)
+                      {
+                          for (const auto &drone : cell)
+                          {
+                              double dx = drone.x - x, dy = drone.y - y;
+                              if (dx * dx + dy * dy <= radius_sq)
+                                  result.push_back(drone);
+                          } });
+            return result;
+        }
+
+        // All drones inside the axis-aligned box [min_x, max_x] x [min_y, max_y]
+        std::vector<DronePosition> within_box(double min_x, double min_y, double max_x, double max_y) const
+        {
+            std::vector<DronePosition> result;
+            std::shared_lock<std::shared_mutex> lock(grid_mutex_);
+            for_cells(min_x, min_y, max_x, max_y, [&](const std::vector<DronePosition> &cell)
+                      {
+                          for (const auto &drone : cell)
+                          {
+                              if (drone.x >= min_x && drone.x <= max_x && drone.y >= min_y && drone.y <= max_y)
+                                  result.push_back(drone);
+                          } });
+            return result;
+        }
+
+        // The k drones nearest to (x, y), closest first, optionally skipping one drone (usually the subject)
+        std::vector<DronePosition> nearest(double x, double y, size_t k, int exclude_id = -1) const
+        {
+            std::vector<std::pair<double, DronePosition>> found;
+            std::shared_lock<std::shared_mutex> lock(grid_mutex_);
+            if (k == 0 || drones_.empty())
+                return {};
+
+            // Search square rings of cells outward, clipped to the occupied bounding box, so
+            // a point far from the fleet starts at the fleet's edge rather than walking empty
+            // rings. Every cell in ring r+1 is at least r * cell_size away, so the search stops
+            // once that exceeds the k-th best distance. If the rings would visit more cells
+            // than are occupied, ordering the occupied cells by distance is cheaper.
+            int64_t cx = cell_coord(x), cy = cell_coord(y);
+            int64_t first_ring = std::max({int64_t(0), min_gx_ - cx, cx - max_gx_, min_gy_ - cy, cy - max_gy_});
+            size_t budget = 4 * cells_.size() + 16, visited = 0;
+            for (int64_t ring = first_ring;; ++ring)
+            {
+                int64_t x0 = std::max(cx - ring, min_gx_), x1 = std::min(cx + ring, max_gx_);
+                int64_t y0 = std::max(cy - ring, min_gy_), y1 = std::min(cy + ring, max_gy_);
+                size_t ring_cells = static_cast<size_t>(std::max<int64_t>(0, 2 * (x1 - x0 + 1) + 2 * (y1 - y0 + 1)));
+                if (visited + ring_cells > budget)
+                {
+                    nearest_by_cell(x, y, k, exclude_id, found);
+                    break;
+                }
+                visited += ring_cells;
+                auto visit = [&](int64_t gx, int64_t gy)
+                {
+                    auto it = cells_.find(cell_key(gx, gy));
+                    if (it == cells_.end())
+                        return;
+                    for (const auto &drone : it->second)
+                    {
+                        if (drone.drone_id == exclude_id)
+                            continue;
+                        double dx = drone.x - x, dy = drone.y - y;
+                        found.emplace_back(dx * dx + dy * dy, drone);
+                    }
+                };
+                // Only the ring's border: interior cells were visited by earlier rings
+                for (int64_t gx = x0; gx <= x1; ++gx)
+                {
+                    if (gx == cx - ring || gx == cx + ring)
+                    {
+                        for (int64_t gy = y0; gy <= y1; ++gy)
+                            visit(gx, gy);
+                        continue;
+                    }
+                    if (cy - ring >= min_gy_)
+                        visit(gx, cy - ring);
+                    if (ring > 0 && cy + ring <= max_gy_)
+                        visit(gx, cy + ring);
+                }
+
+                bool covers_fleet = cx - ring <= min_gx_ && cx + ring >= max_gx_ && cy - ring <= min_gy_ && cy + ring >= max_gy_;
+                if (found.size() >= k)
+                {
+                    std::nth_element(found.begin(), found.begin() + (k - 1), found.end(),
+                                     [](const std::pair<double, DronePosition> &a, const std::pair<double, DronePosition> &b)
+                                     { return a.first < b.first; });
+                    double reach = ring * cell_size_;
+                    if (reach * reach >= found[k - 1].first)
+                        break;
+                }
+                if (covers_fleet)
+                    break;
+            }
+
+            size_t count = std::min(k, found.size());
+            std::partial_sort(found.begin(), found.begin() + count, found.end(),
+                              [](const std::pair<double, DronePosition> &a, const std::pair<double, DronePosition> &b)
+                              { return a.first < b.first; });
+            std::vector<DronePosition> result;
+            result.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+                result.push_back(found[i].second);
+            return result;
+        }
+
+        // Pairs of drones closer than min_distance, at most max_pairs of them. Each drone is
+        // compared only with drones in its own and neighbouring cells, each pair reported
+        // once. The scan stops at max_pairs, so a crowd of co-located drones (every drone
+        // at its start position, say) costs a bounded pass instead of n^2 pairs.
+        ConflictScan conflicts(double min_distance, size_t max_pairs = 10000) const
+        {
+            ConflictScan scan;
+            double limit_sq = min_distance * min_distance;
+            int64_t reach = static_cast<int64_t>(std::ceil(min_distance / cell_size_));
+            std::shared_lock<std::shared_mutex> lock(grid_mutex_);
+            for (const auto &entry : cells_)
+            {
+                const auto &cell = entry.second;
+                if (cell.empty())
+                    continue;
+                int64_t cx = cell_coord(cell.front().x), cy = cell_coord(cell.front().y);
+                for (int64_t gx = cx - reach; gx <= cx + reach; ++gx)
+                {
+                    for (int64_t gy = cy - reach; gy <= cy + reach; ++gy)
+                    {
+                        auto other = cells_.find(cell_key(gx, gy));
+                        if (other == cells_.end())
+                            continue;
+                        for (const auto &a : cell)
+                        {
+                            for (const auto &b : other->second)
+                            {
+                                if (a.drone_id >= b.drone_id)
+                                    continue;
+                                double dx = a.x - b.x, dy = a.y - b.y;
+                                double distance_sq = dx * dx + dy * dy;
+                                if (distance_sq >= limit_sq)
+                                    continue;
+                                if (scan.pairs.size() >= max_pairs)
+                                {
+                                    scan.truncated = true;
+                                    return scan;
+                                }
+                                scan.pairs.push_back(ConflictPair{a.drone_id, b.drone_id, std::sqrt(distance_sq)});
+                            }
+                        }
+                    }
+                }
+            }
+            return scan;
+        }
+
+    private:
+        struct Slot
+        {
+            uint64_t cell;
+            double x;
+            double y;
+            uint64_t seen_ns; // When the last update was applied
+        };
+
+        static uint64_t now_ns()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // k-nearest by occupied cell: cells ordered by their closest point to (x, y), read
+        // until the next cell cannot beat the k-th best. Costs O(cells), not O(drones).
+        void nearest_by_cell(double x, double y, size_t k, int exclude_id, std::vector<std::pair<double, DronePosition>> &found) const
+        {
+            std::vector<std::pair<double, const std::vector<DronePosition> *>> order;
+            order.reserve(cells_.size());
+            for (const auto &entry : cells_)
+            {
+                if (entry.second.empty())
+                    continue;
+                double left = cell_coord(entry.second.front().x) * cell_size_, bottom = cell_coord(entry.second.front().y) * cell_size_;
+                double dx = std::max({left - x, 0.0, x - (left + cell_size_)});
+                double dy = std::max({bottom - y, 0.0, y - (bottom + cell_size_)});
+                order.emplace_back(dx * dx + dy * dy, &entry.second);
+            }
+            std::sort(order.begin(), order.end(), [](const std::pair<double, const std::vector<DronePosition> *> &a, const std::pair<double, const std::vector<DronePosition> *> &b)
+                      { return a.first < b.first; });
+
+            found.clear();
+            for (const auto &cell : order)
+            {
+                if (found.size() >= k)
+                {
+                    std::nth_element(found.begin(), found.begin() + (k - 1), found.end(),
+                                     [](const std::pair<double, DronePosition> &a, const std::pair<double, DronePosition> &b)
+                                     { return a.first < b.first; });
+                    if (cell.first >= found[k - 1].first)
+                        break;
+                }
+                for (const auto &drone : *cell.second)
+                {
+                    if (drone.drone_id == exclude_id)
+                        continue;
+                    double dx = drone.x - x, dy = drone.y - y;
+                    found.emplace_back(dx * dx + dy * dy, drone);
+                }
+            }
+        }
+
+        // The occupied bounding box only grows as drones arrive; expire() shrinks it again
+        void grow_bounds(int64_t gx, int64_t gy)
+        {
+            min_gx_ = std::min(min_gx_, gx);
+            max_gx_ = std::max(max_gx_, gx);
+            min_gy_ = std::min(min_gy_, gy);
+            max_gy_ = std::max(max_gy_, gy);
+        }
+
+        void recompute_bounds()
+        {
+            min_gx_ = min_gy_ = std::numeric_limits<int64_t>::max();
+            max_gx_ = max_gy_ = std::numeric_limits<int64_t>::min();
+            for (const auto &entry : cells_)
+            {
+                if (!entry.second.empty())
+                    grow_bounds(cell_coord(entry.second.front().x), cell_coord(entry.second.front().y));
+            }
+        }
+
+        int64_t cell_coord(double v) const { return static_cast<int64_t>(std::floor(v / cell_size_)); }
+
+        static uint64_t cell_key(int64_t gx, int64_t gy)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(gx)) << 32) | static_cast<uint32_t>(gy);
+        }
+
+        // Visits every non-empty cell overlapping the box. Huge boxes fall back to scanning occupied cells.
+        template <typename Visitor>
+        void for_cells(double min_x, double min_y, double max_x, double max_y, Visitor visit) const
+        {
+            int64_t x0 = cell_coord(min_x), x1 = cell_coord(max_x);
+            int64_t y0 = cell_coord(min_y), y1 = cell_coord(max_y);
+            if (static_cast<double>(x1 - x0 + 1) * static_cast<double>(y1 - y0 + 1) > static_cast<double>(cells_.size()))
+            {
+                for (const auto &entry : cells_)
+                    visit(entry.second);
+                return;
+            }
+            for (int64_t gx = x0; gx <= x1; ++gx)
+            {
+                for (int64_t gy = y0; gy <= y1; ++gy)
+                {
+                    auto it = cells_.find(cell_key(gx, gy));
+                    if (it != cells_.end())
+                        visit(it->second);
+                }
+            }
+        }
+
+        void apply(const std::vector<DronePosition> &batch)
+        {
+            if (batch.empty())
+                return;
+            uint64_t now = now_ns();
+            std::unique_lock<std::shared_mutex> lock(grid_mutex_);
+            for (const auto &update : batch)
+            {
+                int64_t gx = cell_coord(update.x), gy = cell_coord(update.y);
+                uint64_t cell = cell_key(gx, gy);
+                auto it = drones_.find(update.drone_id);
+                if (it != drones_.end() && it->second.cell == cell)
+                {
+                    // Same cell: update in place
+                    for (auto &drone : cells_[cell])
+                    {
+                        if (drone.drone_id == update.drone_id)
+                        {
+                            drone.x = update.x;
+                            drone.y = update.y;
+                            break;
+                        }
+                    }
+                }
+                else
+                {
+                    if (it != drones_.end())
+                        remove_from_cell(it->second.cell, update.drone_id);
+                    cells_[cell].push_back(update);
+                    grow_bounds(gx, gy);
+                }
+                drones_[update.drone_id] = Slot{cell, update.x, update.y, now};
+            }
+        }
+
+        void remove_from_cell(uint64_t cell, int drone_id)
+        {
+            auto it = cells_.find(cell);
+            if (it == cells_.end())
+                return;
+            auto &members = it->second;
+            for (size_t i = 0; i < members.size(); ++i)
+            {
+                if (members[i].drone_id == drone_id)
+                {
+                    members[i] = members.back();
+                    members.pop_back();
+                    break;
+                }
+            }
+            if (members.empty())
+                cells_.erase(it);
+        }
+
+        void run_index()
+        {
+            std::vector<DronePosition> batch;
+            while (running_.load())
+            {
+                {
+                    std::unique_lock<std::mutex> lock(staging_mutex_);
+                    staging_ready_.wait(lock, [this]()
+                                        { return !staging_.empty() || !running_.load(); });
+                    batch.swap(staging_);
+                }
+                apply(batch);
+                batch.clear();
+            }
+        }
+
+        void run_conflicts(double distance, std::chrono::milliseconds period, std::function<void(const ConflictScan &)> on_conflicts,
+                           std::chrono::nanoseconds expire_after, size_t max_pairs)
+        {
+            while (running_.load())
+            {
+                std::this_thread::sleep_for(period);
+                uint64_t now = now_ns();
+                if (expire_after.count() > 0 && now > static_cast<uint64_t>(expire_after.count()))
+                    expire(now - static_cast<uint64_t>(expire_after.count()));
+                if (distance > 0.0)
+                    on_conflicts(conflicts(distance, max_pairs));
+            }
+        }
+
+        double cell_size_;
+
+        mutable std::shared_mutex grid_mutex_;
+        std::unordered_map<uint64_t, std::vector<DronePosition>> cells_;
+        std::unordered_map<int, Slot> drones_;
+        int64_t min_gx_ = std::numeric_limits<int64_t>::max(); // Cells occupied, or once occupied since the last expire()
+        int64_t max_gx_ = std::numeric_limits<int64_t>::min();
+        int64_t min_gy_ = std::numeric_limits<int64_t>::max();
+        int64_t max_gy_ = std::numeric_limits<int64_t>::min();
+
+        std::mutex staging_mutex_;
+        std::condition_variable staging_ready_;
+        std::vector<DronePosition> staging_;
+
+        std::atomic<bool> running_{false};
+        std::thread index_thread_;
+        std::thread conflict_thread_;
+    };
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Parsing of the drones' telemetry lines, e.g.
+//   "Telemetry data from Drone 3 - Session: 2748213 - Seq: 17 - Position: (12.000000, -4.500000) - Altitude: 30.000000"
+// Session and sequence number are optional; drones that number their samples send both.
+// The session is chosen afresh each time the drone starts, and its numbering starts over.
+namespace cc
+{
+    struct TelemetrySample
+    {
+        int drone_id = -1;
+        double x = 0.0;
+        double y = 0.0;
+        double altitude = 0.0;
+        bool has_position = false;
+        uint32_t session = 0; // 0 when the line carries no session
+        uint64_t seq = 0;     // 0 when the line carries no sequence number
+    };
+
+    // Extracts whatever the line carries; drone_id stays -1 and has_position false when absent.
+    // line must be NUL-terminated.
+    inline TelemetrySample parse_telemetry(const char *line)
+    {
+        TelemetrySample sample;
+
+        const char *drone = std::strstr(line, "Drone ");
+        if (drone)
+        {
+            const char *start = drone + 6;
+            char *end = nullptr;
+            long id = std::strtol(start, &end, 10);
+            if (end != start)
+                sample.drone_id = static_cast<int>(id);
+        }
+
+        const char *session = std::strstr(line, "Session: ");
+        if (session)
+            sample.session = static_cast<uint32_t>(std::strtoul(session + 9, nullptr, 10));
+
+        const char *seq = std::strstr(line, "Seq: ");
+        if (seq)
+            sample.seq = std::strtoull(seq + 5, nullptr, 10);
+
+        const char *position = std::strstr(line, "Position: (");
+        if (position)
+        {
+            const char *start = position + 11;
+            char *end = nullptr;
+            sample.x = std::strtod(start, &end);
+            if (end != start && *end == ',')
+            {
+                start = end + 1;
+                sample.y = std::strtod(start, &end);
+                sample.has_position = end != start;
+            }
+        }
+
+        const char *altitude = std::strstr(line, "Altitude: ");
+        if (altitude)
+            sample.altitude = std::strtod(altitude + 10, nullptr);
+
+        return sample;
+    }
+
+    inline TelemetrySample parse_telemetry(const std::string &line) { return parse_telemetry(line.c_str()); }
+}
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// End-to-end command latency tracing.
+//
+// Hops, each stamped on the monotonic clock (CLOCK_MONOTONIC via steady_clock):
+//   sent          server hands the command to the socket
+//   drone_rx      drone receives the datagram
+//   applied       update_position has applied it
+//   telemetry_tx  the next telemetry line carrying the command id leaves the drone
+//   server_rx     the server reads that telemetry line off the socket
+//
+// The drone echoes (id, drone_rx, applied) for every command applied since its last
+// telemetry, plus the telemetry_tx stamp, as a suffix on its telemetry line:
+//   "... - Trace: <tx_ns> <id>:<rx_ns>:<applied_ns> <id>:<rx_ns>:<applied_ns>"
+// Cross-host hops (sent -> drone_rx, telemetry_tx -> server_rx) are only meaningful
+// when both ends share a clock, i.e. on the same host or with synchronised clocks;
+// drone-local hops and the server-side total are always valid.
+//
+// Memory stays bounded on a long run: a command with no echo within the trace timeout
+// is dropped and counted as lost, and only the most recent completed traces are kept
+// for export. The histograms still count every completed trace.
+namespace cc
+{
+    inline uint64_t monotonic_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Drone-side stamps for one applied command, waiting for the next telemetry
+    struct DroneHop
+    {
+        uint32_t id;
+        uint64_t drone_rx;
+        uint64_t applied;
+    };
+
+    inline std::string format_trace_suffix(const std::vector<DroneHop> &hops, uint64_t telemetry_tx)
+    {
+        if (hops.empty())
+            return std::string();
+        std::string suffix = " - Trace: " + std::to_string(telemetry_tx);
+        for (const auto &hop : hops)
+            suffix += " " + std::to_string(hop.id) + ":" + std::to_string(hop.drone_rx) + ":" + std::to_string(hop.applied);
+        return suffix;
+    }
+
+    // Parses the suffix written by format_trace_suffix. Returns false if the line has none.
+    inline bool parse_trace_suffix(const std::string &line, std::vector<DroneHop> &hops, uint64_t &telemetry_tx)
+    {
+        size_t marker = line.find(" - Trace: ");
+        if (marker == std::string::npos)
+            return false;
+
+        const char *cursor = line.c_str() + marker + 10;
+        char *end = nullptr;
+        telemetry_tx = std::strtoull(cursor, &end, 10);
+        if (end == cursor)
+            return false;
+        cursor = end;
+
+        hops.clear();
+        while (*cursor == ' ')
+        {
+            DroneHop hop;
+            hop.id = static_cast<uint32_t>(std::strtoul(cursor + 1, &end, 10));
+            if (*end != ':')
+                break;
+            hop.drone_rx = std::strtoull(end + 1, &end, 10);
+            if (*end != ':')
+                break;
+            hop.applied = std::strtoull(end + 1, &end, 10);
+            hops.push_back(hop);
+            cursor = end;
+        }
+        return !hops.empty();
+    }
+
+    // Log-linear latency histogram: 8 sub-buckets per power of two of nanoseconds,
+    // about 12% resolution from 1 ns to ~70 minutes in a fixed 320-slot array.
+    class LatencyHistogram
+    {
+    public:
+        static constexpr size_t sub_buckets = 8;
+        static constexpr size_t buckets = 40 * sub_buckets;
+
+        void record(uint64_t ns)
+        {
+            counts_[index_of(ns)]++;
+            total_++;
+        }
+
+        uint64_t total() const { return total_; }
+
+        // Upper bound of the bucket holding the p-th quantile
+        uint64_t percentile(double p) const
+        {
+            if (total_ == 0)
+                return 0;
+            uint64_t rank = static_cast<uint64_t>(p * (total_ - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < buckets; ++i)
+            {
+                seen += counts_[i];
+                if (seen >= rank)
+                    return upper_bound(i);
+            }
+            return upper_bound(buckets - 1);
+        }
+
+        size_t bucket_count() const { return buckets; }
+        uint64_t count_at(size_t i) const { return counts_[i]; }
+
+        static uint64_t upper_bound(size_t index)
+        {
+            size_t power = index / sub_buckets;
+            size_t sub = index % sub_buckets;
+            if (power == 0)
+                return sub;
+            uint64_t base = 1ull << (power + 2);
+            return base + (base / sub_buckets) * (sub + 1) - 1;
+        }
+
+    private:
+        static size_t index_of(uint64_t ns)
+        {
+            if (ns < sub_buckets)
+                return static_cast<size_t>(ns);
+            int msb = 63 - __builtin_clzll(ns);               // ns >= 8, so msb >= 3
+            size_t power = static_cast<size_t>(msb - 2);      // power 1 covers [8, 16)
+            size_t sub = static_cast<size_t>((ns >> (msb - 3)) & (sub_buckets - 1));
+            size_t index = power * sub_buckets + sub;
+            return index < buckets ? index : buckets - 1;
+        }
+
+        std::array<uint64_t, buckets> counts_{};
+        uint64_t total_ = 0;
+    };
+
+    struct CommandTrace
+    {
+        uint32_t id = 0;
+        int drone_id = -1;
+        uint64_t sent = 0;
+        uint64_t drone_rx = 0;
+        uint64_t applied = 0;
+        uint64_t telemetry_tx = 0;
+        uint64_t server_rx = 0;
+    };
+
+    // Server-side assembly of per-command traces and per-hop histograms
+    class LatencyTracer
+    {
+    public:
+        enum Hop
+        {
+            Network,     // sent -> drone_rx
+            Apply,       // drone_rx -> applied
+            Report,      // applied -> telemetry_tx
+            Uplink,      // telemetry_tx -> server_rx
+            Total,       // sent -> server_rx
+            HopCount
+        };
+
+        // timeout_ns: how long a command may wait for its echo before it counts as lost;
+        // keep: how many completed traces export_csv can write (the most recent ones)
+        void configure(uint64_t timeout_ns, size_t keep)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            timeout_ns_ = timeout_ns;
+            keep_ = std::max<size_t>(1, keep);
+            std::vector<CommandTrace> recent;
+            for (size_t i = completed_.size() > keep_ ? completed_.size() - keep_ : 0; i < completed_.size(); ++i)
+                recent.push_back(completed_[(oldest_ + i) % completed_.size()]);
+            completed_.swap(recent);
+            oldest_ = 0;
+        }
+
+        uint32_t next_id() { return next_id_++; }
+
+        void command_sent(uint32_t id, int drone_id, uint64_t sent)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            expire(sent);
+            CommandTrace &trace = in_flight_[id];
+            trace.id = id;
+            trace.drone_id = drone_id;
+            trace.sent = sent;
+            send_order_.emplace_back(sent, id);
+        }
+
+        // Feeds one telemetry line received at server_rx; completes any traces it echoes
+        void telemetry_received(const std::string &line, uint64_t server_rx)
+        {
+            std::vector<DroneHop> hops;
+            uint64_t telemetry_tx = 0;
+            if (!parse_trace_suffix(line, hops, telemetry_tx))
+                return;
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            expire(server_rx);
+            for (const auto &hop : hops)
+            {
+                auto it = in_flight_.find(hop.id);
+                if (it == in_flight_.end())
+                    continue; // Sent by an earlier server run, already completed, or lost
+                CommandTrace trace = it->second;
+                in_flight_.erase(it);
+
+                trace.drone_rx = hop.drone_rx;
+                trace.applied = hop.applied;
+                trace.telemetry_tx = telemetry_tx;
+                trace.server_rx = server_rx;
+                histograms_[Network].record(delta(trace.sent, trace.drone_rx));
+                histograms_[Apply].record(delta(trace.drone_rx, trace.applied));
+                histograms_[Report].record(delta(trace.applied, trace.telemetry_tx));
+                histograms_[Uplink].record(delta(trace.telemetry_tx, trace.server_rx));
+                histograms_[Total].record(delta(trace.sent, trace.server_rx));
+                traced_++;
+                if (completed_.size() < keep_)
+                    completed_.push_back(trace);
+                else
+                {
+                    completed_[oldest_] = trace;
+                    oldest_ = (oldest_ + 1) % completed_.size();
+                }
+            }
+        }
+
+        void print_summary()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            expire(monotonic_ns());
+            std::cout << traced_ << " command(s) traced, " << in_flight_.size() << " awaiting telemetry, "
+                      << lost_ << " lost (no echo within " << timeout_ns_ / 1e9 << "s)" << std::endl;
+            for (size_t hop = 0; hop < HopCount; ++hop)
+            {
+                const LatencyHistogram &histogram = histograms_[hop];
+                std::cout << "  " << hop_name(hop) << ": p50=" << histogram.percentile(0.50) / 1000.0
+                          << "us p90=" << histogram.percentile(0.90) / 1000.0
+                          << "us p99=" << histogram.percentile(0.99) / 1000.0 << "us" << std::endl;
+            }
+        }
+
+        // Writes <path> with one row per kept completed command, oldest first, and <path>.hist
+        // with the histogram buckets
+        bool export_csv(const std::string &path)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::ofstream traces(path, std::ios::trunc);
+            std::ofstream buckets(path + ".hist", std::ios::trunc);
+            if (!traces || !buckets)
+                return false;
+
+            traces << "id,drone,sent_ns,drone_rx_ns,applied_ns,telemetry_tx_ns,server_rx_ns\n";
+            for (size_t i = 0; i < completed_.size(); ++i)
+            {
+                const CommandTrace &trace = completed_[(oldest_ + i) % completed_.size()];
+                traces << trace.id << ',' << trace.drone_id << ',' << trace.sent << ',' << trace.drone_rx << ','
+                       << trace.applied << ',' << trace.telemetry_tx << ',' << trace.server_rx << '\n';
+            }
+
+            buckets << "hop,upper_bound_ns,count\n";
+            for (size_t hop = 0; hop < HopCount; ++hop)
+            {
+                for (size_t i = 0; i < histograms_[hop].bucket_count(); ++i)
+                {
+                    if (histograms_[hop].count_at(i) > 0)
+                        buckets << hop_name(hop) << ',' << LatencyHistogram::upper_bound(i) << ',' << histograms_[hop].count_at(i) << '\n';
+                }
+            }
+            return true;
+        }
+
+    private:
+        static uint64_t delta(uint64_t from, uint64_t to) { return to > from ? to - from : 0; }
+
+        // Drops commands sent more than timeout_ns_ before now that are still awaiting
+        // their echo. send_order_ is in send order, so only its expired head is visited.
+        void expire(uint64_t now)
+        {
+            while (!send_order_.empty() && now > timeout_ns_ && send_order_.front().first < now - timeout_ns_)
+            {
+                auto it = in_flight_.find(send_order_.front().second);
+                if (it != in_flight_.end() && it->second.sent == send_order_.front().first)
+                {
+                    in_flight_.erase(it);
+                    lost_++;
+                }
+                send_order_.pop_front();
+            }
+        }
+
+        static const char *hop_name(size_t hop)
+        {
+            static const char *names[HopCount] = {"send->drone_rx", "drone_rx->applied", "applied->telemetry_tx", "telemetry_tx->server_rx", "total"};
+            return names[hop];
+        }
+
+        std::mutex mutex_;
+        std::atomic<uint32_t> next_id_{1};
+        uint64_t timeout_ns_ = 60000000000ULL;
+        size_t keep_ = 100000;
+        std::unordered_map<uint32_t, CommandTrace> in_flight_;
+        std::deque<std::pair<uint64_t, uint32_t>> send_order_; // (sent, id) of every command within the timeout
+        uint64_t lost_ = 0;
+        std::vector<CommandTrace> completed_; // Ring of the most recent completed traces
+        size_t oldest_ = 0;
+        uint64_t traced_ = 0;
+        std::array<LatencyHistogram, HopCount> histograms_;
+    };
+}
@@ -0,0 +1,427 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Server-coordinated scheduling of file uploads.
+//
+// A drone opens its file connection with a header that also states the file size
+// and a priority:
+//   Drone <id> <bytes> <low|normal|urgent>
+// and waits for one line back: "GO" (send the file now on this connection) or
+// "WAIT <ms>" (close, and ask again after that long). A bare "Drone <id>" header is
+// an unscheduled transfer and is accepted as before, with no reply. The server may
+// hold a request open (standby) until a slot frees, so the drones next in line
+// start the moment one does instead of on their next poll.
+//
+// The server admits at most `slots` uploads at once and queues the rest by priority,
+// then by how long they have waited; a drone keeps its place while it comes back
+// within the queue timeout, though a free slot is not held for drones ahead that were
+// told to come back later. The number of slots adapts once per control period to
+// what the server is achieving:
+//   - while every slot is busy and the aggregate ingest rate still grows in
+//     proportion (at least 80% of slots x the best per-upload rate seen), add a slot;
+//   - when the disk is busy writing for more than disk_busy of the period, or
+//     ingest exceeds a configured capacity, cut slots by a quarter;
+//   - when the aggregate rate falls below half of that, so more uploads are only
+//     splitting the same bandwidth, remove a slot.
+// The WAIT a drone is given is how long the server needs, at its measured ingest rate,
+// for the bytes queued ahead of it, so a fleet that asks at the same moment is spread
+// over the time the server needs to take it all.
+namespace cc
+{
+    enum class UploadPriority
+    {
+        Low = 0,
+        Normal = 1,
+        Urgent = 2
+    };
+
+    inline const char *upload_priority_name(UploadPriority priority)
+    {
+        return priority == UploadPriority::Urgent ? "urgent" : priority == UploadPriority::Low ? "low" : "normal";
+    }
+
+    inline bool parse_upload_priority(const std::string &text, UploadPriority &priority)
+    {
+        if (text == "low")
+            priority = UploadPriority::Low;
+        else if (text == "normal")
+            priority = UploadPriority::Normal;
+        else if (text == "urgent")
+            priority = UploadPriority::Urgent;
+        else
+            return false;
+        return true;
+    }
+
+    inline std::string format_upload_request(int drone_id, uint64_t bytes, UploadPriority priority)
+    {
+        return "Drone " + std::to_string(drone_id) + " " + std::to_string(bytes) + " " + upload_priority_name(priority) + "\n";
+    }
+
+    // Returns false for a bare "Drone <id>" header, which asks for no slot
+    inline bool parse_upload_request(const std::string &line, uint64_t &bytes, UploadPriority &priority)
+    {
+        int drone_id;
+        unsigned long long size;
+        char name[16];
+        if (std::sscanf(line.c_str(), "Drone %d %llu %15s", &drone_id, &size, name) != 3 || !parse_upload_priority(name, priority))
+            return false;
+        bytes = size;
+        return true;
+    }
+
+    // "GO" or "WAIT <ms>"; returns false for anything else
+    inline bool parse_upload_reply(const std::string &line, bool &go, uint64_t &wait_ms)
+    {
+        unsigned long long ms;
+        go = line == "GO";
+        if (go)
+            return true;
+        if (std::sscanf(line.c_str(), "WAIT %llu", &ms) != 1)
+            return false;
+        wait_ms = ms;
+        return true;
+    }
+
+    struct UploadOptions
+    {
+        size_t min_slots = 1;
+        size_t max_slots = 64;
+        size_t initial_slots = 4;
+        double capacity = 0.0;                  // Bytes per second the server should not exceed (0 = no fixed limit)
+        double disk_busy = 0.9;                 // Write time, summed over uploads, per period above which slots are cut
+        uint64_t period_ns = 1000000000ull;     // Control period
+        uint64_t queue_timeout_ns = 120000000000ull; // A waiting drone that does not ask again this long loses its place
+        uint64_t min_wait_ms = 200;
+        uint64_t max_wait_ms = 60000;
+    };
+
+    struct UploadDecision
+    {
+        bool go = false;
+        bool standby = false; // Hold the connection and await_slot()
+        uint64_t wait_ms = 0;
+    };
+
+    struct UploadStats
+    {
+        size_t slots = 0;
+        size_t active = 0;
+        size_t waiting = 0;
+        size_t standby = 0;
+        double ingest_rate = 0.0;  // Bytes per second over the last period
+        double disk_busy = 0.0;    // Fraction of the last period spent writing
+        double upload_rate = 0.0;  // Best per-upload rate seen, bytes per second
+        double upload_seconds = 0.0; // Typical upload duration
+        double throughput = 0.0;     // Smoothed ingest rate while uploads run, bytes per second
+        uint64_t granted = 0;
+        uint64_t deferred = 0;
+        uint64_t completed = 0;
+    };
+
+    class UploadScheduler
+    {
+    public:
+        explicit UploadScheduler(const UploadOptions &options = UploadOptions()) { configure(options); }
+
+        void configure(const UploadOptions &options)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            options_ = options;
+            options_.min_slots = std::max<size_t>(1, options_.min_slots);
+            options_.max_slots = std::max(options_.min_slots, options_.max_slots);
+            slots_ = static_cast<double>(std::min(options_.max_slots, std::max(options_.min_slots, options_.initial_slots)));
+        }
+
+        // A drone asks to upload bytes. On GO the upload counts as active until finished().
+        // On standby the caller holds the connection and calls await_slot().
+        UploadDecision request(int drone_id, uint64_t bytes, UploadPriority priority, uint64_t now_ns)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            control(now_ns);
+            UploadDecision decision;
+            if (active_.count(drone_id))
+            {
+                // Still uploading (or its last connection has not been torn down yet)
+                decision.wait_ms = options_.min_wait_ms;
+                ++deferred_;
+                return decision;
+            }
+
+            // Forget drones that stopped asking, then find or add this one
+            waiting_.erase(std::remove_if(waiting_.begin(), waiting_.end(), [&](const Waiter &waiter)
+                                          { return !waiter.standby && now_ns - waiter.last_seen_ns > options_.queue_timeout_ns; }),
+                           waiting_.end());
+            auto it = std::find_if(waiting_.begin(), waiting_.end(), [drone_id](const Waiter &waiter)
+                                   { return waiter.drone_id == drone_id; });
+            if (it == waiting_.end())
+            {
+                waiting_.push_back(Waiter{drone_id, bytes, priority, now_ns, now_ns, now_ns, false});
+                it = waiting_.end() - 1;
+            }
+            else if (it->standby)
+            {
+                // A new connection while the old one is still held: let the old one go
+                it->standby = false;
+                --standby_;
+                slot_freed_.notify_all();
+            }
+            it->bytes = bytes;
+            it->priority = std::max(it->priority, priority);
+            it->last_seen_ns = now_ns;
+            it->due_ns = now_ns;
+            std::stable_sort(waiting_.begin(), waiting_.end(), [](const Waiter &a, const Waiter &b)
+                             { return a.priority != b.priority ? a.priority > b.priority : a.since_ns < b.since_ns; });
+
+            size_t ahead;
+            if (turn_of(drone_id, now_ns, ahead) < free_slots())
+            {
+                grant(ahead, now_ns);
+                decision.go = true;
+                return decision;
+            }
+
+            // Up to one held connection per slot, so a slot that frees is handed on at once
+            if (standby_ < std::max<size_t>(1, static_cast<size_t>(slots_)))
+            {
+                waiting_[ahead].standby = true;
+                ++standby_;
+                decision.standby = true;
+                return decision;
+            }
+
+            // Come back when about one slot's worth of drones is still ahead, i.e. after the
+            // server has taken in the rest of the queue ahead and, on average, half of each
+            // upload in progress. Until an ingest rate has been measured, ask again after
+            // one control period.
+            uint64_t wait_ms = options_.period_ns / 1000000ull;
+            if (throughput_ > 0.0)
+            {
+                double bytes_ahead = 0.0;
+                size_t next_in_line = std::min(ahead, static_cast<size_t>(slots_));
+                for (size_t i = 0; i + next_in_line < ahead; ++i)
+                    bytes_ahead += static_cast<double>(waiting_[i].bytes);
+                for (const auto &entry : active_)
+                    bytes_ahead += static_cast<double>(entry.second.bytes) / 2.0;
+                wait_ms = static_cast<uint64_t>(bytes_ahead / throughput_ * 1000.0);
+            }
+            decision.wait_ms = std::min(options_.max_wait_ms, std::max(options_.min_wait_ms, wait_ms));
+            waiting_[ahead].due_ns = now_ns + decision.wait_ms * 1000000ull;
+            ++deferred_;
+            return decision;
+        }
+
+        // Holds a standby drone until a slot frees up for it. Returns false after timeout_ms
+        // (the drone is then told to come back shortly and keeps its place).
+        bool await_slot(int drone_id, uint64_t timeout_ms)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+            while (true)
+            {
+                uint64_t now_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+                auto it = std::find_if(waiting_.begin(), waiting_.end(), [drone_id](const Waiter &waiter)
+                                       { return waiter.drone_id == drone_id; });
+                if (it == waiting_.end() || !it->standby)
+                    return false; // Superseded by a newer connection from the same drone
+                size_t ahead;
+                if (turn_of(drone_id, now_ns, ahead) < free_slots())
+                {
+                    grant(ahead, now_ns);
+                    return true;
+                }
+                if (slot_freed_.wait_until(lock, deadline) == std::cv_status::timeout)
+                {
+                    it = std::find_if(waiting_.begin(), waiting_.end(), [drone_id](const Waiter &waiter)
+                                      { return waiter.drone_id == drone_id; });
+                    if (it != waiting_.end() && it->standby)
+                    {
+                        it->standby = false;
+                        it->last_seen_ns = now_ns;
+                        it->due_ns = now_ns + options_.min_wait_ms * 1000000ull;
+                        --standby_;
+                        ++deferred_;
+                    }
+                    return false;
+                }
+            }
+        }
+
+        // Bytes received for any upload and the time spent writing them. Called per chunk:
+        // it only takes the lock, and never waits for it, when a control period is due.
+        void progress(uint64_t bytes, uint64_t write_ns, uint64_t now_ns)
+        {
+            bytes_.fetch_add(bytes, std::memory_order_relaxed);
+            write_ns_.fetch_add(write_ns, std::memory_order_relaxed);
+            if (now_ns >= next_control_ns_.load(std::memory_order_relaxed) && mutex_.try_lock())
+            {
+                control(now_ns);
+                mutex_.unlock();
+            }
+        }
+
+        // The upload granted to drone_id ended (completed or failed)
+        void finished(int drone_id, uint64_t now_ns)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = active_.find(drone_id);
+            if (it == active_.end())
+                return;
+            double seconds = static_cast<double>(now_ns - it->second.started_ns) * 1e-9;
+            if (seconds > 0.0)
+                upload_seconds_ = completed_ == 0 ? seconds : upload_seconds_ + (seconds - upload_seconds_) / 8.0;
+            active_.erase(it);
+            ++completed_;
+            control(now_ns);
+            slot_freed_.notify_all();
+        }
+
+        UploadStats stats(uint64_t now_ns)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            control(now_ns);
+            UploadStats stats;
+            stats.slots = static_cast<size_t>(slots_);
+            stats.active = active_.size();
+            stats.waiting = waiting_.size();
+            stats.standby = standby_;
+            stats.ingest_rate = ingest_rate_;
+            stats.disk_busy = disk_busy_;
+            stats.upload_rate = upload_rate_;
+            stats.upload_seconds = upload_seconds_;
+            stats.throughput = throughput_;
+            stats.granted = granted_;
+            stats.deferred = deferred_;
+            stats.completed = completed_;
+            return stats;
+        }
+
+    private:
+        struct Waiter
+        {
+            int drone_id;
+            uint64_t bytes;
+            UploadPriority priority;
+            uint64_t since_ns;     // First asked; sets its place in the queue
+            uint64_t last_seen_ns; // Last asked
+            uint64_t due_ns;       // When it was told to ask again
+            bool standby;          // Its connection is being held for the next free slot
+        };
+
+        struct Active
+        {
+            uint64_t started_ns;
+            uint64_t bytes;
+        };
+
+        // Place in line among drones that can take a slot now: those told to come back
+        // later do not hold a free slot idle. ahead is set to the drone's queue index.
+        size_t turn_of(int drone_id, uint64_t now_ns, size_t &ahead) const
+        {
+            size_t turn = 0;
+            ahead = 0;
+            for (const Waiter &waiter : waiting_)
+            {
+                if (waiter.drone_id == drone_id)
+                    break;
+                ++ahead;
+                if (waiter.standby || waiter.due_ns <= now_ns + options_.min_wait_ms * 1000000ull)
+                    ++turn;
+            }
+            return turn;
+        }
+
+        size_t free_slots() const
+        {
+            size_t slots = static_cast<size_t>(slots_);
+            return slots > active_.size() ? slots - active_.size() : 0;
+        }
+
+        void grant(size_t index, uint64_t now_ns)
+        {
+            const Waiter &waiter = waiting_[index];
+            if (waiter.standby)
+                --standby_;
+            active_[waiter.drone_id] = Active{now_ns, waiter.bytes};
+            waiting_.erase(waiting_.begin() + static_cast<std::ptrdiff_t>(index));
+            ++granted_;
+        }
+
+        // Re-evaluates the slot count at most once per period
+        void control(uint64_t now_ns)
+        {
+            if (last_control_ns_ == 0)
+            {
+                last_control_ns_ = now_ns;
+                next_control_ns_.store(now_ns + options_.period_ns, std::memory_order_relaxed);
+                return;
+            }
+            if (now_ns - last_control_ns_ < options_.period_ns)
+                return;
+            next_control_ns_.store(now_ns + options_.period_ns, std::memory_order_relaxed);
+
+            double seconds = static_cast<double>(now_ns - last_control_ns_) * 1e-9;
+            uint64_t bytes = bytes_.load(std::memory_order_relaxed);
+            uint64_t write_ns = write_ns_.load(std::memory_order_relaxed);
+            ingest_rate_ = static_cast<double>(bytes - last_bytes_) / seconds;
+            disk_busy_ = static_cast<double>(write_ns - last_write_ns_) * 1e-9 / seconds;
+            last_bytes_ = bytes;
+            last_write_ns_ = write_ns;
+            last_control_ns_ = now_ns;
+
+            size_t active = active_.size();
+            if (active == 0)
+                return;
+            throughput_ = throughput_ > 0.0 ? throughput_ + (ingest_rate_ - throughput_) / 4.0 : ingest_rate_;
+            // The best per-upload rate slowly forgets, so a faster past cannot pin it forever
+            upload_rate_ = std::max(upload_rate_ * 0.99, ingest_rate_ / static_cast<double>(active));
+            double expected = upload_rate_ * static_cast<double>(active);
+
+            double slots = slots_;
+            if (disk_busy_ > options_.disk_busy || (options_.capacity > 0.0 && ingest_rate_ > options_.capacity))
+                slots = slots * 0.75;
+            else if (active >= static_cast<size_t>(slots_) && !waiting_.empty() && ingest_rate_ >= 0.8 * expected)
+                slots += 1.0;
+            else if (ingest_rate_ < 0.5 * expected)
+                slots -= 1.0;
+            slots = std::min(static_cast<double>(options_.max_slots), std::max(static_cast<double>(options_.min_slots), slots));
+            if (static_cast<size_t>(slots) > static_cast<size_t>(slots_))
+                slot_freed_.notify_all();
+            slots_ = slots;
+        }
+
+        std::mutex mutex_;
+        UploadOptions options_;
+        double slots_ = 4.0;
+        std::condition_variable slot_freed_;
+        std::vector<Waiter> waiting_; // Kept in grant order
+        size_t standby_ = 0;
+        std::unordered_map<int, Active> active_;
+
+        std::atomic<uint64_t> bytes_{0};
+        std::atomic<uint64_t> write_ns_{0};
+        std::atomic<uint64_t> next_control_ns_{0};
+        uint64_t last_bytes_ = 0;
+        uint64_t last_write_ns_ = 0;
+        uint64_t last_control_ns_ = 0;
+        double ingest_rate_ = 0.0;
+        double disk_busy_ = 0.0;
+        double upload_rate_ = 0.0;
+        double throughput_ = 0.0; // Smoothed ingest rate while uploads are running
+        double upload_seconds_ = 0.0;
+
+        uint64_t granted_ = 0;
+        uint64_t deferred_ = 0;
+        uint64_t completed_ = 0;
+    };
+}
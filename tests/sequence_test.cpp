@@ -0,0 +1,72 @@
+// Checks of the telemetry sequence window (cc_sequence.hpp) and the session field it
+// relies on (cc_telemetry.hpp).
+//
+// Covers a drone that restarts before its counter passes the window, which must not be
+// taken for duplicates, and a sample from the current session that arrives a full window
+// late, which must not be taken for a restart. Exits non-zero on the first failed check.
+//
+// Build: g++ -std=c++17 -O2 -I.. sequence_test.cpp -o sequence_test
+// Run:   ./sequence_test
+
+#include <iostream>
+#include <string>
+#include "cc_sequence.hpp"
+#include "cc_telemetry.hpp"
+
+int failures = 0;
+
+void check(bool ok, const std::string &what)
+{
+    std::cout << (ok ? "ok   " : "FAIL ") << what << std::endl;
+    if (!ok)
+        failures++;
+}
+
+void expect(cc::SequenceVerdict actual, cc::SequenceVerdict wanted, const std::string &what)
+{
+    check(actual == wanted, what + ": " + cc::verdict_name(actual) + (actual == wanted ? "" : std::string(", expected ") + cc::verdict_name(wanted)));
+}
+
+void restart_before_window()
+{
+    cc::SequenceWindow window;
+    for (uint64_t seq = 1; seq <= 30; ++seq)
+        window.observe(7, seq);
+
+    expect(window.observe(8, 1), cc::SequenceVerdict::Restart, "early restart, seq 1");
+    for (uint64_t seq = 2; seq <= 5; ++seq)
+        expect(window.observe(8, seq), cc::SequenceVerdict::InOrder, "early restart, seq " + std::to_string(seq));
+    expect(window.observe(7, 31), cc::SequenceVerdict::Stale, "delayed sample from the old session");
+    expect(window.observe(8, 6), cc::SequenceVerdict::InOrder, "new session continues");
+    check(window.stats().restarts == 1, "one restart counted");
+    check(window.stats().duplicates == 0, "no duplicates counted");
+}
+
+void late_sample_is_not_restart()
+{
+    cc::SequenceWindow window;
+    for (uint64_t seq = 1; seq <= 100; ++seq)
+        window.observe(7, seq);
+
+    expect(window.observe(7, 36), cc::SequenceVerdict::Stale, "seq 36 after 100");
+    expect(window.observe(7, 101), cc::SequenceVerdict::InOrder, "seq 101 after the late sample");
+    check(window.stats().restarts == 0, "no restart counted");
+    check(window.stats().gaps == 0 && window.stats().lost == 0, "no gap or loss booked");
+}
+
+void session_is_parsed()
+{
+    cc::TelemetrySample sample = cc::parse_telemetry("Telemetry data from Drone 3 - Session: 2748213 - Seq: 17 - Position: (12.000000, -4.500000) - Altitude: 30.000000");
+    check(sample.drone_id == 3 && sample.session == 2748213 && sample.seq == 17 && sample.has_position, "session and seq parsed");
+    sample = cc::parse_telemetry("Telemetry data from Drone 3 - Seq: 17 - Position: (12.000000, -4.500000) - Altitude: 30.000000");
+    check(sample.session == 0 && sample.seq == 17, "line without a session");
+}
+
+int main()
+{
+    restart_before_window();
+    late_sample_is_not_restart();
+    session_is_parsed();
+    std::cout << (failures ? "FAILED" : "passed") << std::endl;
+    return failures ? 1 : 0;
+}